@@ -0,0 +1,553 @@
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QSystemTrayIcon>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "CgroupControl.h"
+#include "CpufreqControl.h"
+#include "FakeRyzenSmu.h"
+#include "IconCache.h"
+#include "OverlayWindow.h"
+#include "PerfCounters.h"
+#include "PresetEngine.h"
+#include "ProcessEnergy.h"
+#include "RyzenSmuBackend.h"
+#include "SimulatedBackend.h"
+#include "TrayIconRenderer.h"
+
+// Benchmarks of the preset engine against SimulatedBackend, printed as JSON so
+// the results of two releases can be diffed:
+//   redmiosd_bench --output bench.json --smu-delay 50
+// The micro benchmarks time single engine calls, the macro ones a whole path
+// from its trigger to the first SMU command or to the pixels on screen.
+
+class NoPowerPlan : public PowerPlan
+{
+public:
+    void setBatterySaver(int32_t threshold) override
+    {
+        Q_UNUSED(threshold);
+    }
+};
+
+static void messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& message)
+{
+    Q_UNUSED(context);
+
+    // The engine logs every apply, that would be measured too
+    if (type == QtDebugMsg || type == QtInfoMsg)
+        return;
+
+    std::fprintf(stderr, "%s\n", qPrintable(message));
+}
+
+static QJsonObject summarize(const QString& name, std::vector<int64_t> samples)
+{
+    std::sort(samples.begin(), samples.end());
+
+    auto at = [&samples](double quantile) {
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(quantile * samples.size()))] / 1000.0;
+    };
+
+    double sum = 0.0;
+    for (int64_t sample : samples)
+        sum += sample;
+
+    QJsonObject result;
+    result["name"] = name;
+    result["iterations"] = static_cast<qint64>(samples.size());
+    result["minUs"] = samples.front() / 1000.0;
+    result["medianUs"] = at(0.5);
+    result["p99Us"] = at(0.99);
+    result["maxUs"] = samples.back() / 1000.0;
+    result["meanUs"] = sum / samples.size() / 1000.0;
+
+    std::fprintf(stderr, "%-28s median %10.1f us, p99 %10.1f us\n", qPrintable(name), at(0.5), at(0.99));
+    return result;
+}
+
+template<typename Function>
+static std::vector<int64_t> measure(int32_t iterations, Function function)
+{
+    std::vector<int64_t> samples;
+    samples.reserve(iterations);
+
+    for (int32_t i = 0; i < iterations; ++i)
+    {
+        int64_t start = SimulatedBackend::now();
+        function(i);
+        samples.push_back(SimulatedBackend::now() - start);
+    }
+
+    return samples;
+}
+
+// Presets.json with count presets, each with the args of a typical preset
+static QByteArray generatePresets(int32_t count)
+{
+    QJsonArray presetsArray;
+    for (int32_t i = 0; i < count; ++i)
+    {
+        int32_t limit = 10000 + (i % 50) * 1000;
+
+        QJsonObject argsObject;
+        argsObject["stapm-limit"] = limit;
+        argsObject["fast-limit"] = limit + 5000;
+        argsObject["slow-limit"] = limit;
+        argsObject["tctl-temp"] = 80 + i % 15;
+        argsObject["apu-skin-temp"] = 45;
+        argsObject["vrm-current"] = 60000;
+        argsObject["battery-saver"] = i % 2 ? 100 : 0;
+
+        QJsonObject presetObject;
+        presetObject["name"] = QString("preset%1").arg(i);
+        presetObject["shortcut"] = QString("Ctrl+Alt+F%1").arg(i % 12 + 1);
+        presetObject["args"] = argsObject;
+
+        presetsArray.append(presetObject);
+    }
+
+    QJsonObject rootObject;
+    rootObject["presets"] = presetsArray;
+    rootObject["defaultPreset"] = "preset0";
+    rootObject["lastPreset"] = "preset0";
+    rootObject["updateRate"] = 1000;
+    rootObject["startup"] = false;
+    rootObject["liveEdit"] = false;
+    rootObject["showTray"] = true;
+    rootObject["showOverlay"] = true;
+
+    return QJsonDocument(rootObject).toJson();
+}
+
+static bool writeFile(const QString& filePath, const QByteArray& data)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    return file.write(data) == data.size();
+}
+
+// The shipped Presets.json with every path below rootPath and nothing that
+// starts on its own, the autostart entry left alone
+static QByteArray sandboxPresets(const QByteArray& data, const QString& rootPath)
+{
+    QJsonObject rootObject = QJsonDocument::fromJson(data).object();
+    rootObject["startup"] = false;
+    rootObject["liveEdit"] = false;
+
+    const std::pair<const char*, const char*> paths[] = {
+        { "smu", "ryzen_smu_drv" }, { "cpufreq", "cpufreq" }, { "cgroup", "cgroup" }, { "pressure", "pressure" },
+        { "powerSupply", "power_supply" }, { "energy", "Energy.bin" }
+    };
+
+    for (const auto& path : paths)
+    {
+        QJsonObject object = rootObject[path.first].toObject();
+        object["path"] = QDir(rootPath).filePath(path.second);
+        rootObject[path.first] = object;
+    }
+
+    QJsonObject smuObject = rootObject["smu"].toObject();
+    smuObject["backend"] = "ryzen_smu";
+    rootObject["smu"] = smuObject;
+
+    for (const char* name : { "pressure", "perfCounters", "processWatch", "powerSupply", "metrics", "energy", "processEnergy", "powerProfiles" })
+    {
+        QJsonObject object = rootObject[name].toObject();
+        object["enabled"] = false;
+        rootObject[name] = object;
+    }
+
+    return QJsonDocument(rootObject).toJson();
+}
+
+struct BenchEngine
+{
+    BenchEngine(const QString& filePath, int64_t commandTime)
+        : engine(filePath)
+    {
+        auto simulated = std::make_unique<SimulatedBackend>(commandTime);
+        backend = simulated.get();
+
+        engine.setBackend(std::move(simulated));
+        engine.setPowerPlan(std::make_unique<NoPowerPlan>());
+
+        engine.readPresets();
+        engine.initPreset();
+    }
+
+    PresetEngine engine;
+    SimulatedBackend* backend = nullptr;
+};
+
+static void benchmarkPersistence(QJsonArray& results, const QString& name, const QString& filePath, int32_t iterations)
+{
+    BenchEngine bench(filePath, 0);
+
+    results.append(summarize("parse_" + name, measure(iterations, [&](int32_t) { bench.engine.readPresets(); })));
+    results.append(summarize("serialize_" + name, measure(iterations, [&](int32_t) { bench.engine.writePresets(); })));
+}
+
+static void benchmarkEngine(QJsonArray& results, const QString& filePath, int64_t commandTime, int32_t iterations)
+{
+    BenchEngine bench(filePath, commandTime);
+    PresetEngine& engine = bench.engine;
+
+    engine.start();
+
+    const QMap<QString, int32_t> turboArgs = engine.presets().argsMap["turbo"];
+
+    results.append(summarize("apply_full", measure(iterations, [&](int32_t) { engine.overridePreset(turboArgs); })));
+
+    // A manual switch, apply and Presets.json write included
+    results.append(summarize("switch_preset", measure(iterations, [&](int32_t i) {
+        engine.switchPreset(i % 2 ? "silence" : "turbo");
+    })));
+
+    engine.switchPreset("silence");
+
+    // Hold and release only send the args that differ
+    std::vector<int64_t> hold, release;
+    for (int32_t i = 0; i < iterations; ++i)
+    {
+        int64_t start = SimulatedBackend::now();
+        engine.holdPreset("turbo");
+        hold.push_back(SimulatedBackend::now() - start);
+
+        start = SimulatedBackend::now();
+        engine.releaseHold();
+        release.push_back(SimulatedBackend::now() - start);
+    }
+
+    results.append(summarize("hold_preset", hold));
+    results.append(summarize("release_hold", release));
+
+    results.append(summarize("watchdog_tick", measure(iterations, [&](int32_t) {
+        QMetaObject::invokeMethod(&engine, "updatePreset", Qt::DirectConnection);
+    })));
+
+    // QHotkey delivers activated through a queued call, from there on the
+    // path is the same as for a real key press
+    std::vector<int64_t> hotkey;
+    for (int32_t i = 0; i < iterations; ++i)
+    {
+        const QString preset = i % 2 ? "silence" : "turbo";
+        const uint64_t commands = bench.backend->commandCount();
+
+        int64_t start = SimulatedBackend::now();
+        QMetaObject::invokeMethod(&engine, [&engine, preset]() { engine.switchPreset(preset); }, Qt::QueuedConnection);
+
+        while (bench.backend->commandCount() == commands)
+            QCoreApplication::processEvents();
+
+        hotkey.push_back(bench.backend->lastCommand() - start);
+    }
+
+    results.append(summarize("hotkey_to_smu_write", hotkey));
+}
+
+static void benchmarkRyzenSmu(QJsonArray& results, const QString& filePath, int32_t iterations)
+{
+    FakeRyzenSmu smu;
+    if (!smu.start())
+    {
+        std::fprintf(stderr, "Skipping the ryzen_smu benchmarks, the fake mailbox is not available\n");
+        return;
+    }
+
+    PresetEngine engine(filePath);
+    engine.setBackend(std::make_unique<RyzenSmuBackend>(smu.path()));
+    engine.setPowerPlan(std::make_unique<NoPowerPlan>());
+
+    engine.readPresets();
+    engine.initPreset();
+
+    // Every command is a round trip through the fake mailbox thread, so this
+    // is the cost of the sysfs path itself, without the SMU
+    const QMap<QString, int32_t> turboArgs = engine.presets().argsMap["turbo"];
+
+    results.append(summarize("apply_ryzen_smu", measure(iterations, [&](int32_t) { engine.overridePreset(turboArgs); })));
+}
+
+static void benchmarkCpufreq(QJsonArray& results, const QString& rootPath, int32_t policies, int32_t iterations)
+{
+    QDir directory(rootPath);
+
+    for (int32_t i = 0; i < policies; ++i)
+    {
+        const QString policyPath = QString("policy%1").arg(i);
+        directory.mkpath(policyPath);
+
+        writeFile(directory.filePath(policyPath + "/energy_performance_preference"), "balance_performance\n");
+        writeFile(directory.filePath(policyPath + "/scaling_min_freq"), "400000\n");
+        writeFile(directory.filePath(policyPath + "/scaling_max_freq"), "4000000\n");
+        writeFile(directory.filePath(policyPath + "/boost"), "1\n");
+    }
+
+    CpufreqControl cpufreq;
+    if (!cpufreq.open(rootPath))
+        return;
+
+    const QMap<QString, int32_t> silenceArgs = { { "epp", 4 }, { "scaling-max-freq", 2000000 }, { "boost", 0 } };
+    const QMap<QString, int32_t> turboArgs = { { "epp", 1 }, { "scaling-max-freq", 4000000 }, { "boost", 1 } };
+
+    // Every file of every policy changes, the worst case of a switch
+    results.append(summarize(QString("cpufreq_apply_%1").arg(policies), measure(iterations, [&](int32_t i) {
+        cpufreq.apply(i % 2 ? silenceArgs : turboArgs);
+    })));
+
+    results.append(summarize(QString("cpufreq_unchanged_%1").arg(policies), measure(iterations, [&](int32_t) {
+        cpufreq.apply(turboArgs);
+    })));
+}
+
+static void benchmarkCgroups(QJsonArray& results, const QString& rootPath, int32_t count, int32_t iterations)
+{
+    QDir directory(rootPath);
+
+    QStringList cgroups;
+    for (int32_t i = 0; i < count; ++i)
+    {
+        const QString cgroup = QString("background%1.slice").arg(i);
+        directory.mkpath(cgroup);
+
+        writeFile(directory.filePath(cgroup + "/cpuset.cpus"), "\n");
+        writeFile(directory.filePath(cgroup + "/cpu.max"), "max 100000\n");
+
+        cgroups << cgroup;
+    }
+
+    CgroupControl control;
+    control.open(rootPath, cgroups);
+
+    QMap<QString, CgroupLimits> silenceLimits;
+    for (const QString& cgroup : std::as_const(cgroups))
+        silenceLimits.insert(cgroup, { "0-3", "200000 100000" });
+
+    // Confine and give back, like a silence and turbo switch
+    results.append(summarize(QString("cgroup_switch_%1").arg(count), measure(iterations, [&](int32_t i) {
+        control.apply(i % 2 ? QMap<QString, CgroupLimits>() : silenceLimits);
+    })));
+}
+
+static void benchmarkProcessEnergy(QJsonArray& results, int32_t iterations)
+{
+    ProcessEnergy processEnergy;
+    processEnergy.update(0, 0.0f);
+
+    if (processEnergy.processCount() == 0)
+        return;
+
+    // Every fifth update lists /proc as well, so the samples show both costs
+    std::vector<int64_t> samples;
+    for (int32_t i = 1; i <= iterations; ++i)
+    {
+        processEnergy.update(i * 1000LL, 20.0f);
+        samples.push_back(processEnergy.lastUpdateTime());
+    }
+
+    results.append(summarize(QString("process_energy_%1").arg(processEnergy.processCount()), samples));
+}
+
+static void benchmarkPerfCounters(QJsonArray& results, int32_t iterations)
+{
+    PerfCounters counters;
+    if (!counters.open())
+    {
+        std::fprintf(stderr, "Skipping the perf counter benchmark, perf_event_open is not permitted\n");
+        return;
+    }
+
+    PerfSample sample;
+    results.append(summarize(QString("perf_read_%1_cpus").arg(counters.cpuCount()), measure(iterations, [&](int32_t) {
+        counters.read(sample);
+    })));
+}
+
+static void benchmarkInterface(QJsonArray& results, const QString& filePath, int32_t iterations)
+{
+    // From nothing to a tray icon with the preset shown, like RedmiOSD starts
+    results.append(summarize("startup_to_tray", measure(20, [&](int32_t) {
+        BenchEngine bench(filePath, 0);
+        bench.engine.start();
+
+        IconCache icons;
+        icons.preload(QStringList{ "Default", "Quit" } << bench.engine.presets().argsMap.keys());
+
+        TrayIconRenderer trayRenderer;
+        trayRenderer.setBackground(icons.icon(bench.engine.activePreset()));
+
+        QSystemTrayIcon trayIcon;
+        trayIcon.setIcon(icons.icon(bench.engine.activePreset()));
+        trayIcon.setToolTip(bench.engine.activePreset());
+        trayIcon.show();
+    })));
+
+    results.append(summarize("osd_show_cold", measure(20, [&](int32_t) {
+        OverlayWindow overlay;
+        overlay.showMessage("TURBO");
+    })));
+
+    OverlayWindow overlay;
+    overlay.preload(QStringList{ "SILENCE", "TURBO" });
+
+    results.append(summarize("osd_show_warm", measure(iterations, [&](int32_t i) {
+        overlay.showMessage(i % 2 ? "SILENCE" : "TURBO");
+    })));
+}
+
+// Starts the real executables until their startup is done, the daemon
+// against the GUI build. They exit once Presets.json is read and the
+// interface is built, before the preset engine opens anything, and run on a
+// sandboxed Presets.json in case they get that far anyway. The GUI needs a
+// system tray, without one it is skipped.
+static void benchmarkStartup(QJsonArray& results, const QString& workingPath, QProcessEnvironment environment)
+{
+    const std::pair<const char*, const char*> builds[] = { { "daemon", REDMIOSD_DAEMON_PATH }, { "gui", REDMIOSD_GUI_PATH } };
+
+    environment.insert("REDMIOSD_STARTUP_PROBE", "1");
+
+    for (const auto& build : builds)
+    {
+        std::vector<int64_t> startupTimes;
+        std::vector<int64_t> residentSizes;
+
+        for (int32_t i = 0; i < 5; ++i)
+        {
+            QProcess process;
+            process.setProcessEnvironment(environment);
+            process.setWorkingDirectory(workingPath);
+            process.start(build.second, QStringList());
+
+            if (!process.waitForFinished(10000) || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0)
+                break;
+
+            const QList<QByteArray> values = process.readAllStandardOutput().trimmed().split(' ');
+            if (values.size() != 2)
+                break;
+
+            startupTimes.push_back(values[0].toLongLong());
+            residentSizes.push_back(values[1].toLongLong());
+        }
+
+        if (startupTimes.empty())
+        {
+            std::fprintf(stderr, "%-28s skipped, %s did not start\n", qPrintable(QString("startup_") + build.first), build.second);
+            continue;
+        }
+
+        std::sort(startupTimes.begin(), startupTimes.end());
+        std::sort(residentSizes.begin(), residentSizes.end());
+
+        QJsonObject result;
+        result["name"] = QString("startup_") + build.first;
+        result["iterations"] = static_cast<qint64>(startupTimes.size());
+        result["medianMs"] = static_cast<qint64>(startupTimes[startupTimes.size() / 2]);
+        result["medianRssKiB"] = static_cast<qint64>(residentSizes[residentSizes.size() / 2]);
+
+        std::fprintf(stderr, "%-28s median %10lld ms, RSS %7lld KiB\n", qPrintable(QString("startup_") + build.first),
+            static_cast<long long>(startupTimes[startupTimes.size() / 2]), static_cast<long long>(residentSizes[residentSizes.size() / 2]));
+        results.append(result);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // The executables are started with the display of the caller
+    const QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+
+    // Runs on machines without a display as well
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    qInstallMessageHandler(messageHandler);
+
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks the preset engine against a simulated SMU.");
+    parser.addHelpOption();
+
+    QCommandLineOption outputOption("output", "Write the JSON results to <file> instead of stdout.", "file");
+    QCommandLineOption delayOption("smu-delay", "Cost of every simulated SMU command in <us>, 0 by default.", "us", "0");
+    QCommandLineOption iterationsOption("iterations", "Iterations of the micro benchmarks, 1000 by default.", "count", "1000");
+
+    parser.addOption(outputOption);
+    parser.addOption(delayOption);
+    parser.addOption(iterationsOption);
+    parser.process(app);
+
+    const int64_t commandTime = parser.value(delayOption).toLongLong() * 1000;
+    const int32_t iterations = std::max(1, parser.value(iterationsOption).toInt());
+
+    QTemporaryDir directory;
+    const QString defaultPath = directory.filePath("Presets.json");
+    const QString largePath = directory.filePath("Presets1000.json");
+
+    const QString startupPath = directory.filePath("startup");
+
+    QFile source(REDMIOSD_PRESETS_PATH);
+    if (!source.open(QIODevice::ReadOnly))
+    {
+        std::fprintf(stderr, "Failed to read %s\n", REDMIOSD_PRESETS_PATH);
+        return 1;
+    }
+
+    const QByteArray presets = source.readAll();
+    if (!writeFile(defaultPath, presets) || !writeFile(largePath, generatePresets(1000))
+        || !QDir().mkpath(startupPath) || !writeFile(QDir(startupPath).filePath("Presets.json"), sandboxPresets(presets, startupPath)))
+    {
+        std::fprintf(stderr, "Failed to prepare the preset files in %s\n", qPrintable(directory.path()));
+        return 1;
+    }
+
+    QJsonArray results;
+
+    benchmarkPersistence(results, "default", defaultPath, iterations);
+    benchmarkPersistence(results, "1000", largePath, std::max(1, iterations / 20));
+    benchmarkEngine(results, defaultPath, commandTime, iterations);
+    benchmarkRyzenSmu(results, defaultPath, iterations);
+    benchmarkCpufreq(results, directory.filePath("cpufreq"), 32, iterations);
+    benchmarkCgroups(results, directory.filePath("cgroup"), 4, iterations);
+    benchmarkProcessEnergy(results, iterations);
+    benchmarkPerfCounters(results, iterations);
+    benchmarkInterface(results, defaultPath, iterations);
+    benchmarkStartup(results, startupPath, environment);
+
+    QJsonObject rootObject;
+    rootObject["qt"] = qVersion();
+    rootObject["smuDelayUs"] = commandTime / 1000.0;
+    rootObject["benchmarks"] = results;
+
+    QByteArray json = QJsonDocument(rootObject).toJson();
+
+    if (!parser.isSet(outputOption))
+    {
+        std::fwrite(json.constData(), 1, json.size(), stdout);
+        return 0;
+    }
+
+    if (!writeFile(parser.value(outputOption), json))
+    {
+        std::fprintf(stderr, "Failed to write %s\n", qPrintable(parser.value(outputOption)));
+        return 1;
+    }
+
+    return 0;
+}
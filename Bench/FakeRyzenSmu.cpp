@@ -0,0 +1,148 @@
+#include "FakeRyzenSmu.h"
+
+#include <QFile>
+#include <QThread>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "RyzenSmuBackend.h"
+
+constexpr uint64_t g_tableSize = 0x400;
+
+FakeRyzenSmu::FakeRyzenSmu()
+{
+}
+
+FakeRyzenSmu::~FakeRyzenSmu()
+{
+    stop();
+}
+
+bool FakeRyzenSmu::start()
+{
+#ifdef Q_OS_LINUX
+    if (!m_directory.isValid())
+        return false;
+
+    auto createFile = [this](const char* name, const QByteArray& data) {
+        QFile file(m_directory.filePath(name));
+        return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+    };
+
+    const uint64_t tableSize = g_tableSize;
+
+    if (!createFile("smu_args", QByteArray(24, '\0'))
+        || !createFile("mp1_smu_cmd", QByteArray(4, '\0'))
+        || !createFile("pm_table", QByteArray(g_tableSize, '\0'))
+        || !createFile("pm_table_size", QByteArray(reinterpret_cast<const char*>(&tableSize), sizeof(tableSize))))
+        return false;
+
+    QByteArray rootPath = m_directory.path().toLocal8Bit();
+    m_argsFd = ::open((rootPath + "/smu_args").constData(), O_RDONLY | O_CLOEXEC);
+    m_commandFd = ::open((rootPath + "/mp1_smu_cmd").constData(), O_RDWR | O_CLOEXEC);
+    m_tableFd = ::open((rootPath + "/pm_table").constData(), O_RDWR | O_CLOEXEC);
+
+    m_inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd < 0 || ::inotify_add_watch(m_inotifyFd, (rootPath + "/mp1_smu_cmd").constData(), IN_MODIFY) < 0)
+    {
+        stop();
+        return false;
+    }
+
+    m_running = true;
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->start();
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FakeRyzenSmu::stop()
+{
+    m_running = false;
+
+    if (m_thread != nullptr)
+    {
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+#ifdef Q_OS_LINUX
+    for (int* fd : { &m_inotifyFd, &m_argsFd, &m_commandFd, &m_tableFd })
+    {
+        if (*fd >= 0)
+            ::close(*fd);
+
+        *fd = -1;
+    }
+#endif
+}
+
+QString FakeRyzenSmu::path() const
+{
+    return m_directory.path();
+}
+
+void FakeRyzenSmu::run()
+{
+#ifdef Q_OS_LINUX
+    alignas(inotify_event) char buffer[4096];
+
+    while (m_running)
+    {
+        pollfd descriptor = { m_inotifyFd, POLLIN, 0 };
+        if (::poll(&descriptor, 1, 50) <= 0)
+            continue;
+
+        while (::read(m_inotifyFd, buffer, sizeof(buffer)) > 0)
+        {
+        }
+
+        answer();
+    }
+#endif
+}
+
+void FakeRyzenSmu::answer()
+{
+#ifdef Q_OS_LINUX
+    uint32_t command = 0;
+    if (::pread(m_commandFd, &command, sizeof(command), 0) != sizeof(command))
+        return;
+
+    // Our own status write shows up as a modification too
+    if (command == RyzenSmuBackend::StatusOk || command == RyzenSmuBackend::StatusUnknownCommand)
+        return;
+
+    uint32_t args[6] = {};
+    if (::pread(m_argsFd, args, sizeof(args), 0) != sizeof(args))
+        return;
+
+    // Limit and value side by side, like the first entries of a real table
+    int32_t offset = -1;
+    switch (command)
+    {
+        case 0x14: offset = 0x00; break;
+        case 0x15: offset = 0x08; break;
+        case 0x16: offset = 0x10; break;
+        default: break;
+    }
+
+    if (offset >= 0)
+    {
+        const float limits[2] = { args[0] / 1000.0f, args[0] / 1000.0f * 0.8f };
+        ::pwrite(m_tableFd, limits, sizeof(limits), offset);
+    }
+
+    uint32_t status = RyzenSmuBackend::commands().key(command).isEmpty() ? RyzenSmuBackend::StatusUnknownCommand : RyzenSmuBackend::StatusOk;
+    ::pwrite(m_commandFd, &status, sizeof(status), 0);
+#endif
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QTemporaryDir>
+
+#include <atomic>
+
+QT_BEGIN_NAMESPACE
+class QThread;
+QT_END_NAMESPACE
+
+// The sysfs files of the ryzen_smu module in a temporary directory, so
+// RyzenSmuBackend runs without the driver. A thread answers every command
+// written to mp1_smu_cmd: limits land in pm_table in W and the status
+// reads back as OK. Linux only, it is driven by inotify.
+class FakeRyzenSmu
+{
+public:
+    FakeRyzenSmu();
+    ~FakeRyzenSmu();
+
+    bool start();
+    void stop();
+
+    QString path() const;
+
+private:
+    void run();
+    void answer();
+
+    QTemporaryDir m_directory;
+    QThread* m_thread = nullptr;
+    std::atomic<bool> m_running = false;
+
+    int m_inotifyFd = -1;
+    int m_argsFd = -1;
+    int m_commandFd = -1;
+    int m_tableFd = -1;
+};
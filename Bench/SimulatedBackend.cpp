@@ -0,0 +1,88 @@
+#include "SimulatedBackend.h"
+
+#include <chrono>
+
+SimulatedBackend::SimulatedBackend(int64_t commandTime)
+    : m_commandTime(commandTime)
+{
+    const QStringList argNames = SmuBackend::argNames();
+    m_argNames = QSet<QString>(argNames.begin(), argNames.end());
+}
+
+SimulatedBackend::~SimulatedBackend()
+{
+}
+
+int64_t SimulatedBackend::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool SimulatedBackend::init()
+{
+    return true;
+}
+
+bool SimulatedBackend::isReady() const
+{
+    return true;
+}
+
+bool SimulatedBackend::hasArg(const QString& name) const
+{
+    return m_argNames.contains(name);
+}
+
+int32_t SimulatedBackend::applyArg(const QString& name, int32_t value)
+{
+    m_lastCommand = now();
+    ++m_commandCount;
+
+    spin(m_commandTime);
+
+    m_values.insert(name, value);
+    return 0;
+}
+
+void SimulatedBackend::refreshTable()
+{
+    spin(m_commandTime);
+}
+
+void SimulatedBackend::readTelemetry(Telemetry& telemetry)
+{
+    // ryzenadj reports W for limits set in mW
+    telemetry.stapmLimit = m_values.value("stapm-limit") / 1000.0f;
+    telemetry.fastLimit = m_values.value("fast-limit") / 1000.0f;
+    telemetry.slowLimit = m_values.value("slow-limit") / 1000.0f;
+    telemetry.stapmValue = telemetry.stapmLimit * 0.8f;
+    telemetry.fastValue = telemetry.fastLimit * 0.8f;
+    telemetry.slowValue = telemetry.slowLimit * 0.8f;
+    telemetry.socketPower = telemetry.stapmValue;
+    telemetry.tctlTemp = 60.0f;
+
+    telemetry.coreCount = 8;
+    for (int32_t i = 0; i < telemetry.coreCount; ++i)
+        telemetry.coreClocks[i] = 3.2f;
+}
+
+int64_t SimulatedBackend::lastCommand() const
+{
+    return m_lastCommand;
+}
+
+uint64_t SimulatedBackend::commandCount() const
+{
+    return m_commandCount;
+}
+
+void SimulatedBackend::spin(int64_t duration) const
+{
+    if (duration <= 0) return;
+
+    // Busy wait, a sleep would measure the scheduler instead
+    int64_t end = now() + duration;
+    while (now() < end)
+    {
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QHash>
+#include <QSet>
+
+#include "SmuBackend.h"
+
+// Stands in for the SMU in benchmarks. Limits read back as they were set, so
+// the watchdog sees no drift, and every command can be given a fixed cost to
+// stand for the mailbox round trip of a real SMU.
+class SimulatedBackend : public SmuBackend
+{
+public:
+    explicit SimulatedBackend(int64_t commandTime = 0);
+    virtual ~SimulatedBackend();
+
+    // Steady clock in ns, shared with the benchmarks
+    static int64_t now();
+
+    bool init() override;
+    bool isReady() const override;
+
+    bool hasArg(const QString& name) const override;
+    int32_t applyArg(const QString& name, int32_t value) override;
+
+    void refreshTable() override;
+    void readTelemetry(Telemetry& telemetry) override;
+
+    int64_t lastCommand() const;
+    uint64_t commandCount() const;
+
+private:
+    void spin(int64_t duration) const;
+
+    QSet<QString> m_argNames;
+    QHash<QString, int32_t> m_values;
+
+    int64_t m_commandTime = 0;
+    int64_t m_lastCommand = 0;
+    uint64_t m_commandCount = 0;
+};
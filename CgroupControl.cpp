@@ -0,0 +1,193 @@
+#include "CgroupControl.h"
+
+#include <QDebug>
+#include <QDir>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+constexpr int32_t g_cpusFile = 0;
+constexpr int32_t g_maxFile = 1;
+
+CgroupControl::CgroupControl()
+{
+}
+
+CgroupControl::~CgroupControl()
+{
+    close();
+}
+
+void CgroupControl::open(const QString& rootPath, const QStringList& cgroups)
+{
+    if (rootPath != m_rootPath)
+    {
+        close();
+        m_rootPath = rootPath;
+    }
+
+    // Cgroups no preset names anymore go back to how they were found
+    for (auto it = m_cgroups.begin(); it != m_cgroups.end();)
+    {
+        if (cgroups.contains(it.key()))
+        {
+            ++it;
+            continue;
+        }
+
+        closeCgroup(it.key(), it.value());
+        it = m_cgroups.erase(it);
+    }
+
+#ifdef Q_OS_LINUX
+    QDir directory(rootPath);
+
+    for (const QString& cgroup : cgroups)
+    {
+        if (m_cgroups.contains(cgroup))
+            continue;
+
+        std::vector<File> files(2);
+
+        bool opened = openFile(directory.filePath(cgroup + "/cpuset.cpus"), files[g_cpusFile]);
+        opened = openFile(directory.filePath(cgroup + "/cpu.max"), files[g_maxFile]) || opened;
+
+        if (!opened)
+        {
+            qDebug() << "Failed to open cgroup" << directory.filePath(cgroup) << strerror(errno);
+            continue;
+        }
+
+        m_cgroups.insert(cgroup, std::move(files));
+    }
+#else
+    Q_UNUSED(cgroups);
+#endif
+}
+
+void CgroupControl::close()
+{
+    // Gives the cgroups back as they were found
+    QMap<QString, CgroupLimits> none;
+    apply(none);
+
+    for (auto it = m_cgroups.begin(); it != m_cgroups.end(); ++it)
+        closeCgroup(it.key(), it.value());
+
+    m_cgroups.clear();
+}
+
+bool CgroupControl::isOpen() const
+{
+    return !m_cgroups.isEmpty();
+}
+
+bool CgroupControl::apply(const QMap<QString, CgroupLimits>& limits)
+{
+    if (m_cgroups.isEmpty()) return true;
+
+    std::vector<Write> writes;
+
+    for (auto it = m_cgroups.begin(); it != m_cgroups.end(); ++it)
+    {
+        const CgroupLimits cgroupLimits = limits.value(it.key());
+        std::vector<File>& files = it.value();
+
+        const QByteArray values[2] =
+        {
+            cgroupLimits.cpus.isEmpty() ? files[g_cpusFile].original : cgroupLimits.cpus.toLatin1(),
+            cgroupLimits.max.isEmpty() ? files[g_maxFile].original : cgroupLimits.max.toLatin1(),
+        };
+
+        for (int32_t i = 0; i < 2; ++i)
+        {
+            if (files[i].fd >= 0 && files[i].value != values[i])
+                writes.push_back({ &files[i], values[i] });
+        }
+    }
+
+    for (size_t i = 0; i < writes.size(); ++i)
+    {
+        const QByteArray previous = writes[i].file->value;
+
+        if (writeFile(*writes[i].file, writes[i].value))
+        {
+            writes[i].value = previous;
+            continue;
+        }
+
+        qDebug() << "Cgroup write rejected:" << writes[i].value << "rolling back" << i << "writes";
+
+        // The value of each written file was swapped for the previous one
+        for (size_t j = i; j-- > 0;)
+            writeFile(*writes[j].file, writes[j].value);
+
+        return false;
+    }
+
+    return true;
+}
+
+void CgroupControl::closeCgroup(const QString& cgroup, std::vector<File>& files) const
+{
+#ifdef Q_OS_LINUX
+    for (File& file : files)
+    {
+        if (file.fd < 0)
+            continue;
+
+        if (file.value != file.original && !writeFile(file, file.original))
+            qDebug() << "Failed to restore cgroup" << cgroup << file.original << strerror(errno);
+
+        ::close(file.fd);
+        file.fd = -1;
+    }
+#else
+    Q_UNUSED(cgroup);
+    Q_UNUSED(files);
+#endif
+}
+
+bool CgroupControl::openFile(const QString& filePath, File& file) const
+{
+#ifdef Q_OS_LINUX
+    file.fd = ::open(filePath.toLocal8Bit().constData(), O_RDWR | O_CLOEXEC);
+    if (file.fd < 0)
+        return false;
+
+    char buffer[256];
+    ssize_t length = ::pread(file.fd, buffer, sizeof(buffer), 0);
+    if (length > 0)
+        file.value = QByteArray(buffer, length).trimmed();
+
+    file.original = file.value;
+    return true;
+#else
+    Q_UNUSED(filePath);
+    Q_UNUSED(file);
+    return false;
+#endif
+}
+
+bool CgroupControl::writeFile(File& file, const QByteArray& value) const
+{
+#ifdef Q_OS_LINUX
+    // An empty write never reaches the kernel, an empty cpuset is a newline
+    const QByteArray data = value.isEmpty() ? QByteArray("\n") : value;
+
+    if (::pwrite(file.fd, data.constData(), data.size(), 0) != data.size())
+        return false;
+
+    file.value = value;
+    return true;
+#else
+    Q_UNUSED(file);
+    Q_UNUSED(value);
+    return false;
+#endif
+}
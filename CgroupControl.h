@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+struct CgroupSettings
+{
+    QString rootPath = "/sys/fs/cgroup";
+};
+
+// What a preset sets for one cgroup, empty values are left alone
+struct CgroupLimits
+{
+    QString cpus;
+    QString max;
+};
+
+// cgroup v2 cpuset.cpus and cpu.max of the cgroups the presets name, relative
+// to rootPath. The files stay open and remember the value they had when they
+// were opened, a cgroup the active preset does not mention goes back to it.
+// A switch is all or nothing: when one write fails, the files written before
+// it are rolled back.
+class CgroupControl
+{
+public:
+    CgroupControl();
+    ~CgroupControl();
+
+    // Opens the files of cgroups that are not open yet and restores and closes
+    // the ones that are not in cgroups anymore, a new root starts over
+    void open(const QString& rootPath, const QStringList& cgroups);
+    void close();
+
+    bool isOpen() const;
+
+    bool apply(const QMap<QString, CgroupLimits>& limits);
+
+private:
+    struct File
+    {
+        int fd = -1;
+        QByteArray value;
+        QByteArray original;
+    };
+
+    struct Write
+    {
+        File* file;
+        QByteArray value;
+    };
+
+    void closeCgroup(const QString& cgroup, std::vector<File>& files) const;
+    bool openFile(const QString& filePath, File& file) const;
+    bool writeFile(File& file, const QByteArray& value) const;
+
+    QString m_rootPath;
+
+    // Keyed by cgroup, cpuset.cpus first and cpu.max second
+    QHash<QString, std::vector<File>> m_cgroups;
+};
@@ -0,0 +1,293 @@
+#include "CommandLine.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTextStream>
+
+#include <cstdio>
+#include <cstring>
+
+#include "ControlClient.h"
+#include "Log.h"
+#include "PresetEngine.h"
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+using namespace ControlProtocol;
+
+static void attachConsole()
+{
+#ifdef Q_OS_WIN
+    // RedmiOSD is a WIN32 executable, borrow the console of the calling shell
+    if (AttachConsole(ATTACH_PARENT_PROCESS))
+    {
+        std::freopen("CONOUT$", "w", stdout);
+        std::freopen("CONOUT$", "w", stderr);
+    }
+#endif
+}
+
+static QString formatLatency(int64_t nsecs)
+{
+    return QString::number(nsecs / 1000000.0, 'f', 3) + " ms";
+}
+
+static bool sendRequest(ControlClient& client, Command command, const QByteArray& payload, QByteArray& response, QTextStream& out)
+{
+    Status status;
+    if (!client.request(command, payload, status, response))
+    {
+        out << "The running instance did not answer." << Qt::endl;
+        return false;
+    }
+
+    switch (status)
+    {
+        case Status::Ok:
+            return true;
+        case Status::UnknownPreset:
+            out << "Unknown preset: " << QString::fromUtf8(payload) << Qt::endl;
+            return false;
+        default:
+            out << "The running instance rejected the request." << Qt::endl;
+            return false;
+    }
+}
+
+static int forwardCommandLine(ControlClient& client, const QString& preset, const QMap<QString, int32_t>& args, bool info, QTextStream& out)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QByteArray response;
+
+    if (!preset.isEmpty() && !sendRequest(client, Command::SwitchPreset, preset.toUtf8(), response, out))
+        return 1;
+
+    if (!args.isEmpty() && !sendRequest(client, Command::Override, encodeArgs(args), response, out))
+        return 1;
+
+    int64_t applyTime = timer.nsecsElapsed();
+
+    if (info)
+    {
+        Telemetry telemetry;
+        if (!sendRequest(client, Command::Telemetry, QByteArray(), response, out) || !decodeTelemetry(response, telemetry))
+            return 1;
+
+        if (!sendRequest(client, Command::QueryPreset, QByteArray(), response, out))
+            return 1;
+
+        out << "Active Preset | " << QString::fromUtf8(response) << Qt::endl;
+        out << "Socket Power  | " << telemetry.socketPower << Qt::endl;
+        out << "Tctl Temp     | " << telemetry.tctlTemp << Qt::endl;
+        out << "STAPM         | " << telemetry.stapmValue << " / " << telemetry.stapmLimit << Qt::endl;
+        out << "Fast          | " << telemetry.fastValue << " / " << telemetry.fastLimit << Qt::endl;
+        out << "Slow          | " << telemetry.slowValue << " / " << telemetry.slowLimit << Qt::endl;
+    }
+
+    if (!preset.isEmpty() || !args.isEmpty())
+        out << "Forwarded to the running instance in " << formatLatency(applyTime) << Qt::endl;
+
+    return 0;
+}
+
+static int traceCommandLine(ControlClient& client, const QString& trace, const QString& dumpPath, QTextStream& out)
+{
+    QByteArray response;
+
+    if (!trace.isEmpty())
+    {
+        if (trace != "start" && trace != "stop")
+        {
+            out << "Unknown trace action: " << trace << Qt::endl;
+            return 1;
+        }
+
+        TraceAction action = trace == "start" ? TraceAction::Start : TraceAction::Stop;
+        if (!sendRequest(client, Command::Trace, QByteArray(1, static_cast<char>(action)), response, out))
+            return 1;
+
+        out << "Tracing " << (action == TraceAction::Start ? "started" : "stopped") << Qt::endl;
+    }
+
+    if (!dumpPath.isEmpty())
+    {
+        // The running instance may have another working directory
+        QString filePath = QFileInfo(dumpPath).absoluteFilePath();
+
+        QByteArray payload(1, static_cast<char>(TraceAction::Dump));
+        payload.append(filePath.toUtf8());
+
+        if (!sendRequest(client, Command::Trace, payload, response, out))
+            return 1;
+
+        out << "Trace written to " << filePath << Qt::endl;
+    }
+
+    return 0;
+}
+
+static int applyCommandLine(const QString& preset, const QMap<QString, int32_t>& args, bool info, QTextStream& out)
+{
+    if (info)
+    {
+        out << "No running instance of RedmiOSD." << Qt::endl;
+        return 1;
+    }
+
+    PresetEngine engine("Presets.json");
+    engine.readPresets();
+
+    QMap<QString, int32_t> presetArgs;
+    if (!preset.isEmpty())
+    {
+        if (!engine.presets().argsMap.contains(preset))
+        {
+            out << "Unknown preset: " << preset << Qt::endl;
+            return 1;
+        }
+
+        presetArgs = engine.presets().argsMap[preset];
+    }
+
+    presetArgs.insert(args);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!engine.initBackend())
+    {
+        out << "Failed to initialize the SMU backend." << Qt::endl;
+        return 1;
+    }
+
+    int64_t initTime = timer.nsecsElapsed();
+    timer.restart();
+
+    engine.overridePreset(presetArgs);
+
+    int64_t applyTime = timer.nsecsElapsed();
+
+    Log::flush();
+
+    out << "Applied standalone in " << formatLatency(initTime + applyTime)
+        << " (driver init " << formatLatency(initTime) << ", apply " << formatLatency(applyTime) << ")" << Qt::endl;
+
+    return 0;
+}
+
+bool hasCommandLine(int argc, char* argv[])
+{
+    // Only our own options, Qt takes -platform, -style, -reverse and the like
+    const QStringList names = QStringList{ "apply", "info", "trace", "trace-dump", "energy", "help", "help-all" } << PresetEngine::argNames();
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "-?") == 0)
+            return true;
+
+        if (std::strncmp(argv[i], "--", 2) != 0)
+            continue;
+
+        QString name = QString::fromLocal8Bit(argv[i] + 2).section('=', 0, 0);
+        if (names.contains(name))
+            return true;
+    }
+
+    return false;
+}
+
+int runCommandLine(const QCoreApplication& app)
+{
+    attachConsole();
+
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Applies a preset or ryzenadj args, through the running instance when there is one.");
+    parser.addHelpOption();
+
+    QCommandLineOption applyOption("apply", "Switch to <preset>.", "preset");
+    QCommandLineOption infoOption("info", "Print the telemetry of the running instance.");
+    QCommandLineOption traceOption("trace", "Start or stop span tracing in the running instance.", "start|stop");
+    QCommandLineOption energyOption("energy", "Print the energy spent per preset and day by the running instance.");
+    QCommandLineOption traceDumpOption("trace-dump", "Write the spans of the running instance to <file> as Chrome trace JSON.", "file");
+
+    parser.addOption(applyOption);
+    parser.addOption(infoOption);
+    parser.addOption(traceOption);
+    parser.addOption(traceDumpOption);
+    parser.addOption(energyOption);
+
+    QList<QCommandLineOption> argOptions;
+    for (const QString& name : PresetEngine::argNames())
+        argOptions.append(QCommandLineOption(name, QString("Set %1.").arg(name), "value"));
+
+    parser.addOptions(argOptions);
+    parser.process(app);
+
+    QMap<QString, int32_t> args;
+    for (const QCommandLineOption& option : argOptions)
+    {
+        if (!parser.isSet(option))
+            continue;
+
+        const QString name = option.names().first();
+        if (name != "epp")
+        {
+            args.insert(name, parser.value(option).toInt());
+            continue;
+        }
+
+        int32_t epp = CpufreqControl::parseEpp(parser.value(option));
+        if (epp < 0)
+        {
+            out << "Unknown epp: " << parser.value(option) << ", one of " << CpufreqControl::eppNames().join(", ") << Qt::endl;
+            return 1;
+        }
+
+        args.insert(name, epp);
+    }
+
+    QString preset = parser.value(applyOption);
+    bool info = parser.isSet(infoOption);
+
+    ControlClient client;
+
+    if (parser.isSet(traceOption) || parser.isSet(traceDumpOption))
+    {
+        if (!client.connectToServer())
+        {
+            out << "No running instance of RedmiOSD." << Qt::endl;
+            return 1;
+        }
+
+        return traceCommandLine(client, parser.value(traceOption), parser.value(traceDumpOption), out);
+    }
+
+    if (parser.isSet(energyOption))
+    {
+        QByteArray response;
+        if (!client.connectToServer())
+        {
+            out << "No running instance of RedmiOSD." << Qt::endl;
+            return 1;
+        }
+
+        if (!sendRequest(client, Command::Energy, QByteArray(), response, out))
+            return 1;
+
+        out << QString::fromUtf8(response);
+        return 0;
+    }
+
+    if (client.connectToServer())
+        return forwardCommandLine(client, preset, args, info, out);
+
+    return applyCommandLine(preset, args, info, out);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <QtGlobal>
+
+QT_BEGIN_NAMESPACE
+class QCoreApplication;
+QT_END_NAMESPACE
+
+// ryzenadj style command line, e.g. "RedmiOSD --apply turbo" or
+// "RedmiOSD --stapm-limit=15000 --fast-limit=35000". With a running instance
+// the request is forwarded over the control socket, so it goes through the
+// already open ryzenadj handle and the watchdog keeps it, otherwise it is
+// applied standalone.
+bool hasCommandLine(int argc, char* argv[]);
+int runCommandLine(const QCoreApplication& app);
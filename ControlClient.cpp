@@ -0,0 +1,37 @@
+#include "ControlClient.h"
+
+using namespace ControlProtocol;
+
+bool ControlClient::connectToServer(int32_t timeout)
+{
+    m_socket.connectToServer(ServerName);
+    return m_socket.waitForConnected(timeout);
+}
+
+bool ControlClient::request(Command command, const QByteArray& payload, Status& status, QByteArray& response, int32_t timeout)
+{
+    m_socket.write(encodeFrame(uint8_t(command), payload));
+    if (!m_socket.waitForBytesWritten(timeout))
+        return false;
+
+    while (m_socket.bytesAvailable() < HeaderSize)
+    {
+        if (!m_socket.waitForReadyRead(timeout))
+            return false;
+    }
+
+    char header[HeaderSize];
+    m_socket.read(header, HeaderSize);
+
+    quint16 size = qFromLittleEndian<quint16>(header);
+    while (m_socket.bytesAvailable() < size)
+    {
+        if (!m_socket.waitForReadyRead(timeout))
+            return false;
+    }
+
+    status = static_cast<Status>(static_cast<uint8_t>(header[2]));
+    response = m_socket.read(size);
+
+    return true;
+}
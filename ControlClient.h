@@ -0,0 +1,17 @@
+#pragma once
+
+#include <QLocalSocket>
+
+#include "ControlProtocol.h"
+
+// Blocking client of the control socket, used by the command line
+class ControlClient
+{
+public:
+    bool connectToServer(int32_t timeout = 100);
+
+    bool request(ControlProtocol::Command command, const QByteArray& payload, ControlProtocol::Status& status, QByteArray& response, int32_t timeout = 1000);
+
+private:
+    QLocalSocket m_socket;
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include <QtEndian>
+
+#include <cstring>
+#include <iterator>
+
+#include "Telemetry.h"
+
+// Frames on the control socket are [u16 payload length][u8 code][payload],
+// little endian. Requests carry a Command, responses carry a Status.
+namespace ControlProtocol
+{
+    constexpr const char* ServerName = "RedmiOSD";
+    constexpr int32_t HeaderSize = 3;
+
+    enum class Command : uint8_t
+    {
+        Ping = 0,
+        SwitchPreset = 1,
+        QueryPreset = 2,
+        Override = 3,
+        Telemetry = 4,
+        Trace = 5,
+        Energy = 6,
+    };
+
+    enum class Status : uint8_t
+    {
+        Ok = 0,
+        Error = 1,
+        UnknownCommand = 2,
+        UnknownPreset = 3,
+    };
+
+    // Trace payload, [u8 TraceAction][file path when dumping]
+    enum class TraceAction : uint8_t
+    {
+        Stop = 0,
+        Start = 1,
+        Dump = 2,
+    };
+
+    inline QByteArray encodeFrame(uint8_t code, const QByteArray& payload)
+    {
+        QByteArray frame(HeaderSize + payload.size(), Qt::Uninitialized);
+        qToLittleEndian<quint16>(static_cast<quint16>(payload.size()), frame.data());
+        frame[2] = static_cast<char>(code);
+        std::memcpy(frame.data() + HeaderSize, payload.constData(), payload.size());
+
+        return frame;
+    }
+
+    // Override payload, repeated [u8 key length][key][i32 value]
+    inline QByteArray encodeArgs(const QMap<QString, int32_t>& args)
+    {
+        QByteArray payload;
+        for (auto it = args.constBegin(); it != args.constEnd(); ++it)
+        {
+            QByteArray key = it.key().toUtf8().left(255);
+            char value[4];
+            qToLittleEndian<qint32>(it.value(), value);
+
+            payload.append(static_cast<char>(key.size()));
+            payload.append(key);
+            payload.append(value, sizeof(value));
+        }
+
+        return payload;
+    }
+
+    inline bool decodeArgs(const QByteArray& payload, QMap<QString, int32_t>& args)
+    {
+        int32_t offset = 0;
+        while (offset < payload.size())
+        {
+            int32_t keySize = static_cast<uint8_t>(payload[offset++]);
+            if (offset + keySize + 4 > payload.size())
+                return false;
+
+            QString key = QString::fromUtf8(payload.constData() + offset, keySize);
+            offset += keySize;
+
+            args.insert(key, qFromLittleEndian<qint32>(payload.constData() + offset));
+            offset += 4;
+        }
+
+        return true;
+    }
+
+    // Telemetry payload, i64 timestamp followed by f32 fields in declaration order
+    inline QByteArray encodeTelemetry(const Telemetry& telemetry)
+    {
+        const float values[] = {
+            telemetry.socketPower, telemetry.tctlTemp,
+            telemetry.stapmValue, telemetry.stapmLimit,
+            telemetry.fastValue, telemetry.fastLimit,
+            telemetry.slowValue, telemetry.slowLimit,
+        };
+
+        QByteArray payload(8 + sizeof(values), Qt::Uninitialized);
+        qToLittleEndian<qint64>(telemetry.timestamp, payload.data());
+        qToLittleEndian<float>(values, std::size(values), payload.data() + 8);
+
+        return payload;
+    }
+
+    inline bool decodeTelemetry(const QByteArray& payload, Telemetry& telemetry)
+    {
+        float values[8];
+        if (payload.size() != static_cast<int32_t>(8 + sizeof(values)))
+            return false;
+
+        telemetry.timestamp = qFromLittleEndian<qint64>(payload.constData());
+        qFromLittleEndian<float>(payload.constData() + 8, std::size(values), values);
+
+        telemetry.socketPower = values[0];
+        telemetry.tctlTemp = values[1];
+        telemetry.stapmValue = values[2];
+        telemetry.stapmLimit = values[3];
+        telemetry.fastValue = values[4];
+        telemetry.fastLimit = values[5];
+        telemetry.slowValue = values[6];
+        telemetry.slowLimit = values[7];
+
+        return true;
+    }
+}
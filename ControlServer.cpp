@@ -0,0 +1,163 @@
+#include "ControlServer.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QLocalSocket>
+#include <QLockFile>
+#include <QStandardPaths>
+
+#include "PresetEngine.h"
+#include "Trace.h"
+
+using namespace ControlProtocol;
+
+ControlServer::ControlServer(PresetEngine& engine, QObject* parent)
+    : QObject(parent)
+    , m_engine(engine)
+{
+    connect(&m_server, &QLocalServer::newConnection, this, &ControlServer::newConnection);
+}
+
+ControlServer::~ControlServer()
+{
+}
+
+bool ControlServer::listen()
+{
+    m_server.setSocketOptions(QLocalServer::UserAccessOption);
+    m_server.setMaxPendingConnections(64);
+
+    // Two instances started at once both pass the check of main(), the lock
+    // keeps the second from removing the socket the first just created
+    QLockFile lock(QDir(QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation)).filePath(QString(ServerName) + ".lock"));
+    if (!lock.tryLock(5000))
+    {
+        qDebug() << "Failed to lock the control socket:" << lock.error();
+        return false;
+    }
+
+    if (m_server.listen(ServerName))
+        return true;
+
+    // A crashed instance leaves its socket file behind, only that one is removed
+    if (m_server.serverError() == QAbstractSocket::AddressInUseError)
+    {
+        QLocalSocket socket;
+        socket.connectToServer(ServerName);
+
+        if (socket.waitForConnected(1000))
+        {
+            qDebug() << "Another instance is listening on the control socket.";
+            return false;
+        }
+
+        QLocalServer::removeServer(ServerName);
+
+        if (m_server.listen(ServerName))
+            return true;
+    }
+
+    qDebug() << "Failed to listen on control socket:" << m_server.errorString();
+    return false;
+}
+
+void ControlServer::newConnection()
+{
+    while (QLocalSocket* socket = m_server.nextPendingConnection())
+    {
+        connect(socket, &QLocalSocket::readyRead, this, &ControlServer::socketReadyRead);
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void ControlServer::socketReadyRead()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+    if (socket == nullptr) return;
+
+    char header[HeaderSize];
+
+    while (socket->bytesAvailable() >= HeaderSize)
+    {
+        socket->peek(header, HeaderSize);
+
+        quint16 size = qFromLittleEndian<quint16>(header);
+        if (socket->bytesAvailable() < HeaderSize + size)
+            break;
+
+        socket->read(header, HeaderSize);
+        QByteArray payload = socket->read(size);
+
+        socket->write(handleRequest(static_cast<Command>(static_cast<uint8_t>(header[2])), payload));
+    }
+
+    socket->flush();
+}
+
+QByteArray ControlServer::handleRequest(Command command, const QByteArray& payload)
+{
+    switch (command)
+    {
+        case Command::Ping:
+            return encodeFrame(uint8_t(Status::Ok), payload);
+
+        case Command::SwitchPreset:
+        {
+            QString preset = QString::fromUtf8(payload);
+            if (!m_engine.presets().argsMap.contains(preset))
+                return encodeFrame(uint8_t(Status::UnknownPreset), QByteArray());
+
+            m_engine.switchPreset(preset);
+            return encodeFrame(uint8_t(Status::Ok), QByteArray());
+        }
+
+        case Command::QueryPreset:
+            return encodeFrame(uint8_t(Status::Ok), m_engine.activePreset().toUtf8());
+
+        case Command::Override:
+        {
+            QMap<QString, int32_t> args;
+            if (!decodeArgs(payload, args))
+                return encodeFrame(uint8_t(Status::Error), QByteArray());
+
+            m_engine.overridePreset(args);
+            return encodeFrame(uint8_t(Status::Ok), QByteArray());
+        }
+
+        case Command::Telemetry:
+            return encodeFrame(uint8_t(Status::Ok), encodeTelemetry(m_engine.telemetry()));
+
+        case Command::Trace:
+        {
+            if (payload.isEmpty())
+                return encodeFrame(uint8_t(Status::Error), QByteArray());
+
+            TraceAction action = static_cast<TraceAction>(static_cast<uint8_t>(payload[0]));
+            if (action == TraceAction::Dump)
+            {
+                QString filePath = QString::fromUtf8(payload.mid(1));
+                return encodeFrame(uint8_t(Trace::dump(filePath) ? Status::Ok : Status::Error), QByteArray());
+            }
+
+            Trace::setEnabled(action == TraceAction::Start);
+            return encodeFrame(uint8_t(Status::Ok), QByteArray());
+        }
+
+        case Command::Energy:
+        {
+            QString report = m_engine.energy().report();
+
+            if (m_engine.presets().processEnergy.enabled)
+            {
+                report += "processes\n";
+                for (const ProcessPower& process : m_engine.processEnergy().top())
+                    report += QString("  %1 %2 W %3 Wh\n").arg(QString::fromUtf8(process.name), -16).arg(process.power, 6, 'f', 1).arg(process.energy / 3600.0, 8, 'f', 2);
+            }
+
+            // The oldest days are dropped when the report outgrows a frame
+            return encodeFrame(uint8_t(Status::Ok), report.toUtf8().right(0xFFFF));
+        }
+    }
+
+    return encodeFrame(uint8_t(Status::UnknownCommand), QByteArray());
+}
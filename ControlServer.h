@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QLocalServer>
+#include <QObject>
+
+#include "ControlProtocol.h"
+
+QT_BEGIN_NAMESPACE
+class QLocalSocket;
+QT_END_NAMESPACE
+
+class PresetEngine;
+
+// Local control socket of the running instance, see ControlProtocol.h
+class ControlServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ControlServer(PresetEngine& engine, QObject* parent = nullptr);
+    virtual ~ControlServer();
+
+    bool listen();
+
+private slots:
+    void newConnection();
+    void socketReadyRead();
+
+private:
+    QByteArray handleRequest(ControlProtocol::Command command, const QByteArray& payload);
+
+    PresetEngine& m_engine;
+    QLocalServer m_server;
+};
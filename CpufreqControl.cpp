@@ -0,0 +1,360 @@
+#include "CpufreqControl.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+#include "Log.h"
+
+// Below this many writes a batch is cheaper on the calling thread alone
+constexpr int32_t g_parallelWrites = 8;
+constexpr int32_t g_maxThreads = 4;
+
+static const char* const g_knobFiles[] =
+{
+    "energy_performance_preference",
+    "scaling_min_freq",
+    "scaling_max_freq",
+    "boost",
+};
+
+static const char* const g_knobArgs[] =
+{
+    "epp",
+    "scaling-min-freq",
+    "scaling-max-freq",
+    "boost",
+};
+
+QStringList CpufreqControl::argNames()
+{
+    return QStringList
+    {
+        "boost",
+        "epp",
+        "scaling-max-freq",
+        "scaling-min-freq",
+    };
+}
+
+const QStringList& CpufreqControl::eppNames()
+{
+    static const QStringList eppNames
+    {
+        "default",
+        "performance",
+        "balance_performance",
+        "balance_power",
+        "power",
+    };
+
+    return eppNames;
+}
+
+int32_t CpufreqControl::parseEpp(const QString& value)
+{
+    int32_t index = eppNames().indexOf(value);
+    if (index >= 0)
+        return index;
+
+    // toInt() would take any other name for 0, which is "default"
+    bool ok = false;
+    index = value.toInt(&ok);
+
+    return ok && index >= 0 && index < eppNames().size() ? index : -1;
+}
+
+CpufreqControl::CpufreqControl()
+{
+    m_pool.setMaxThreadCount(std::clamp(QThread::idealThreadCount() / 2, 1, g_maxThreads));
+    m_pool.setExpiryTimeout(-1);
+}
+
+CpufreqControl::~CpufreqControl()
+{
+    close();
+}
+
+bool CpufreqControl::open(const QString& rootPath)
+{
+    close();
+
+#ifdef Q_OS_LINUX
+    QDir directory(rootPath);
+
+    const QStringList policyNames = directory.entryList(QStringList{ "policy*" }, QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& policyName : policyNames)
+    {
+        Policy policy;
+        policy.index = policyName.mid(6).toInt();
+
+        for (int32_t knob = 0; knob < KnobCount; ++knob)
+            policy.files[knob] = openFile(directory.filePath(policyName + "/" + g_knobFiles[knob]));
+
+        if (m_eppAvailable.isEmpty())
+        {
+            File available = openFile(directory.filePath(policyName + "/energy_performance_available_preferences"));
+            m_eppAvailable = available.value.simplified().split(' ');
+            m_eppAvailable.removeAll(QByteArray());
+            closeFile(available);
+        }
+
+        m_policies.push_back(policy);
+    }
+
+    // Per policy boost is recent, older kernels only have the global switch
+    m_globalBoost = openFile(directory.filePath("boost"));
+
+    if (m_policies.empty())
+    {
+        qDebug() << "No cpufreq policies found in" << rootPath;
+        return false;
+    }
+
+    qDebug() << "cpufreq control opened" << m_policies.size() << "policies in" << rootPath;
+    return true;
+#else
+    Q_UNUSED(rootPath);
+    return false;
+#endif
+}
+
+void CpufreqControl::close()
+{
+    m_pool.waitForDone();
+
+    for (Policy& policy : m_policies)
+    {
+        for (File& file : policy.files)
+            closeFile(file);
+    }
+
+    m_policies.clear();
+    m_eppAvailable.clear();
+    closeFile(m_globalBoost);
+}
+
+bool CpufreqControl::isOpen() const
+{
+    return !m_policies.empty();
+}
+
+int32_t CpufreqControl::policyCount() const
+{
+    return static_cast<int32_t>(m_policies.size());
+}
+
+bool CpufreqControl::hasArg(const QString& name) const
+{
+    for (const char* arg : g_knobArgs)
+    {
+        if (name == QLatin1String(arg))
+            return true;
+    }
+
+    return false;
+}
+
+int32_t CpufreqControl::apply(const QMap<QString, int32_t>& args)
+{
+    if (m_policies.empty()) return 0;
+
+    Batch batch;
+    bool any = false;
+
+    for (int32_t knob = 0; knob < KnobCount; ++knob)
+    {
+        auto it = args.constFind(QLatin1String(g_knobArgs[knob]));
+        if (it == args.constEnd())
+            continue;
+
+        if (knob == Epp)
+        {
+            bool valid = it.value() >= 0 && it.value() < eppNames().size();
+            const QByteArray value = valid ? eppNames()[it.value()].toLatin1() : QByteArray::number(it.value());
+
+            // Without the list, e.g. on a fake tree, the driver has the last word
+            if (!valid || (!m_eppAvailable.isEmpty() && !m_eppAvailable.contains(value)))
+            {
+                REDMIOSD_LOG(Apply, LogEvent::EppRejected, value.constData());
+                continue;
+            }
+
+            batch.values[knob] = value;
+        }
+        else if (knob == Boost)
+        {
+            batch.values[knob] = it.value() != 0 ? "1" : "0";
+        }
+        else
+        {
+            batch.values[knob] = QByteArray::number(it.value());
+        }
+
+        batch.set[knob] = true;
+        any = true;
+    }
+
+    if (!any) return 0;
+
+    int32_t failed = 0;
+
+    if (batch.set[Boost] && m_globalBoost.fd >= 0)
+        failed += writeFile(m_globalBoost, batch.values[Boost], -1);
+
+    // Only the files whose value changes cost a write
+    std::vector<Policy*> pending;
+    int32_t writes = 0;
+
+    for (Policy& policy : m_policies)
+    {
+        int32_t policyWrites = 0;
+        for (int32_t knob = 0; knob < KnobCount; ++knob)
+        {
+            if (batch.set[knob] && policy.files[knob].fd >= 0 && policy.files[knob].value != batch.values[knob])
+                ++policyWrites;
+        }
+
+        if (policyWrites > 0)
+        {
+            pending.push_back(&policy);
+            writes += policyWrites;
+        }
+    }
+
+    if (pending.empty()) return failed;
+
+    int32_t threads = writes < g_parallelWrites ? 1 : std::min<int32_t>(m_pool.maxThreadCount() + 1, pending.size());
+
+    std::atomic<int32_t> poolFailed = 0;
+
+    // The calling thread takes the first share, the pool the others
+    for (int32_t thread = 1; thread < threads; ++thread)
+    {
+        m_pool.start([this, &pending, &batch, &poolFailed, thread, threads]() {
+            int32_t threadFailed = 0;
+            for (size_t i = thread; i < pending.size(); i += threads)
+                threadFailed += applyPolicy(*pending[i], batch);
+
+            poolFailed += threadFailed;
+        });
+    }
+
+    for (size_t i = 0; i < pending.size(); i += threads)
+        failed += applyPolicy(*pending[i], batch);
+
+    if (threads > 1)
+        m_pool.waitForDone();
+
+    return failed + poolFailed;
+}
+
+void CpufreqControl::refresh()
+{
+    for (Policy& policy : m_policies)
+    {
+        for (File& file : policy.files)
+            readFile(file);
+    }
+
+    readFile(m_globalBoost);
+}
+
+CpufreqControl::File CpufreqControl::openFile(const QString& filePath) const
+{
+    File file;
+
+#ifdef Q_OS_LINUX
+    file.fd = ::open(filePath.toLocal8Bit().constData(), O_RDWR | O_CLOEXEC);
+    readFile(file);
+#else
+    Q_UNUSED(filePath);
+#endif
+
+    return file;
+}
+
+void CpufreqControl::readFile(File& file) const
+{
+#ifdef Q_OS_LINUX
+    if (file.fd < 0)
+        return;
+
+    char buffer[128];
+    ssize_t length = ::pread(file.fd, buffer, sizeof(buffer), 0);
+    file.value = length > 0 ? QByteArray(buffer, length).trimmed() : QByteArray();
+#else
+    Q_UNUSED(file);
+#endif
+}
+
+void CpufreqControl::closeFile(File& file)
+{
+#ifdef Q_OS_LINUX
+    if (file.fd >= 0)
+        ::close(file.fd);
+#endif
+
+    file.fd = -1;
+    file.value.clear();
+}
+
+int32_t CpufreqControl::writeFile(File& file, const QByteArray& value, int32_t policy) const
+{
+#ifdef Q_OS_LINUX
+    if (file.fd < 0 || file.value == value)
+        return 0;
+
+    if (::pwrite(file.fd, value.constData(), value.size(), 0) != value.size())
+    {
+        // The cache is left alone, so the next apply tries again
+        REDMIOSD_LOG(Apply, LogEvent::CpufreqFailed, value.constData(), policy, errno);
+        return 1;
+    }
+
+    file.value = value;
+    return 0;
+#else
+    Q_UNUSED(file);
+    Q_UNUSED(value);
+    Q_UNUSED(policy);
+    return 0;
+#endif
+}
+
+int32_t CpufreqControl::applyPolicy(Policy& policy, const Batch& batch) const
+{
+    int32_t failed = 0;
+
+    // The driver rejects a minimum above the current maximum and the other
+    // way around. A new minimum that would cross the maximum in place waits
+    // for the new one, the default order covers a new maximum below the
+    // current minimum.
+    bool maxFirst = batch.set[MinFreq] && batch.values[MinFreq].toLongLong() > policy.files[MaxFreq].value.toLongLong();
+
+    const Knob order[KnobCount] =
+    {
+        Epp,
+        maxFirst ? MaxFreq : MinFreq,
+        maxFirst ? MinFreq : MaxFreq,
+        Boost,
+    };
+
+    for (Knob knob : order)
+    {
+        if (batch.set[knob])
+            failed += writeFile(policy.files[knob], batch.values[knob], policy.index);
+    }
+
+    return failed;
+}
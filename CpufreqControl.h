@@ -0,0 +1,92 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+#include <vector>
+
+struct CpufreqSettings
+{
+    QString rootPath = "/sys/devices/system/cpu/cpufreq";
+};
+
+// cpufreq knobs of every policy* directory under rootPath, as preset args: epp
+// (amd-pstate energy_performance_preference), scaling-min-freq and
+// scaling-max-freq (kHz) and boost. The files stay open and the last value of
+// each is cached, so only changed values are written. Larger batches are
+// spread over a small thread pool, since every write waits for the driver.
+class CpufreqControl
+{
+public:
+    enum Knob
+    {
+        Epp,
+        MinFreq,
+        MaxFreq,
+        Boost,
+        KnobCount
+    };
+
+    static QStringList argNames();
+
+    // EPP is an index into these, Presets.json may use the names as well.
+    // parseEpp() returns -1 for anything else.
+    static const QStringList& eppNames();
+    static int32_t parseEpp(const QString& value);
+
+    CpufreqControl();
+    ~CpufreqControl();
+
+    bool open(const QString& rootPath);
+    void close();
+
+    bool isOpen() const;
+    int32_t policyCount() const;
+
+    bool hasArg(const QString& name) const;
+
+    // Writes the cpufreq args among args, returns the number of failed writes
+    int32_t apply(const QMap<QString, int32_t>& args);
+
+    // Re-reads the cached values, so the next apply also corrects what other
+    // tools changed since
+    void refresh();
+
+private:
+    struct File
+    {
+        int fd = -1;
+        QByteArray value;
+    };
+
+    struct Policy
+    {
+        int32_t index = 0;
+        File files[KnobCount];
+    };
+
+    struct Batch
+    {
+        bool set[KnobCount] = {};
+        QByteArray values[KnobCount];
+    };
+
+    File openFile(const QString& filePath) const;
+    void readFile(File& file) const;
+    void closeFile(File& file);
+
+    int32_t writeFile(File& file, const QByteArray& value, int32_t policy) const;
+    int32_t applyPolicy(Policy& policy, const Batch& batch) const;
+
+    std::vector<Policy> m_policies;
+    File m_globalBoost;
+
+    // energy_performance_available_preferences, empty when there is none
+    QList<QByteArray> m_eppAvailable;
+
+    QThreadPool m_pool;
+};
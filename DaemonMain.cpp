@@ -0,0 +1,106 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QVector>
+
+#include <algorithm>
+
+#include "ControlClient.h"
+#include "Log.h"
+#include "ProcessStats.h"
+#include "RedmiDaemon.h"
+
+static int pingInstance(int32_t count)
+{
+    using namespace ControlProtocol;
+
+    ControlClient client;
+    if (!client.connectToServer())
+    {
+        qWarning() << "No running instance of RedmiOSD.";
+        return 1;
+    }
+
+    QVector<int64_t> samples;
+    samples.reserve(count);
+
+    QByteArray payload(8, '\0');
+    QByteArray response;
+    Status status;
+
+    QElapsedTimer timer;
+    for (int32_t i = 0; i < count; ++i)
+    {
+        timer.start();
+
+        if (!client.request(Command::Ping, payload, status, response))
+        {
+            qWarning() << "Ping failed after" << i << "requests.";
+            return 1;
+        }
+
+        samples.append(timer.nsecsElapsed());
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    qInfo() << "Round trip over" << count << "requests, us:"
+            << "min" << samples.first() / 1000.0
+            << "median" << samples[count / 2] / 1000.0
+            << "p99" << samples[count * 99 / 100] / 1000.0
+            << "max" << samples.last() / 1000.0;
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+
+    QCommandLineOption pingOption("ping", "Measure control socket round trips against the running instance.", "count");
+    parser.addOption(pingOption);
+
+    parser.process(app);
+
+    if (parser.isSet(pingOption))
+        return pingInstance(std::max(1, parser.value(pingOption).toInt()));
+
+    ControlClient client;
+    if (client.connectToServer())
+    {
+        qWarning() << "Another instance of RedmiOSD is already running.";
+        return 1;
+    }
+
+    Log::start();
+
+    RedmiDaemon daemon;
+
+    if (reportStartupProbe(startupTimer.elapsed()))
+    {
+        Log::stop();
+        return 0;
+    }
+
+    if (!daemon.start())
+    {
+        qWarning() << "Failed to listen on the control socket, another instance of RedmiOSD may be running.";
+        Log::stop();
+        return 1;
+    }
+
+    qInfo() << "Started in" << startupTimer.elapsed() << "ms, RSS" << residentMemory() << "KiB";
+
+    int result = app.exec();
+
+    Log::stop();
+
+    return result;
+}
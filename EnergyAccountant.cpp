@@ -0,0 +1,284 @@
+#include "EnergyAccountant.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+constexpr uint32_t g_storeMagic = 0x52454E45; // "ENER"
+constexpr uint32_t g_storeVersion = 1;
+
+static_assert(std::is_trivially_copyable_v<EnergyTotals>, "EnergyTotals is written to disk as is");
+
+// Local calendar day, so a summary matches the day the user sees
+static int64_t localDay(int64_t timestamp)
+{
+    QDateTime dateTime = QDateTime::fromMSecsSinceEpoch(timestamp);
+    return dateTime.date().toJulianDay();
+}
+
+static void addTotals(EnergyTotals& totals, double energy, double duration, float power)
+{
+    totals.energy += energy;
+    totals.duration += duration;
+    totals.peakPower = std::max(totals.peakPower, power);
+}
+
+static void writeTotals(QTextStream& out, const char* name, const EnergyTotals& totals)
+{
+    if (totals.duration <= 0.0)
+        return;
+
+    int64_t minutes = static_cast<int64_t>(totals.duration / 60.0);
+
+    out << "  " << qSetFieldWidth(16) << Qt::left << name << qSetFieldWidth(0)
+        << QString("%1h %2m").arg(minutes / 60).arg(minutes % 60, 2, 10, QChar('0')).rightJustified(9)
+        << QString::number(totals.energy / 3600.0, 'f', 2).rightJustified(10) << " Wh"
+        << QString::number(totals.energy / totals.duration, 'f', 1).rightJustified(8) << " W avg"
+        << QString::number(totals.peakPower, 'f', 1).rightJustified(8) << " W peak"
+        << Qt::endl;
+}
+
+EnergyAccountant::EnergyAccountant()
+{
+    m_store.magic = g_storeMagic;
+    m_store.version = g_storeVersion;
+}
+
+EnergyAccountant::~EnergyAccountant()
+{
+    save();
+}
+
+bool EnergyAccountant::load(const QString& filePath)
+{
+    m_filePath = filePath;
+
+    QFile file(filePath);
+    if (!file.exists())
+        return true;
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Failed to open energy store:" << file.errorString();
+        return false;
+    }
+
+    Store store;
+    if (file.read(reinterpret_cast<char*>(&store), sizeof(store)) != sizeof(store)
+        || store.magic != g_storeMagic || store.version != g_storeVersion)
+    {
+        qDebug() << "Energy store is invalid, starting over:" << filePath;
+        return false;
+    }
+
+    m_store = store;
+    return true;
+}
+
+bool EnergyAccountant::save()
+{
+    if (m_filePath.isEmpty() || !m_dirty)
+        return true;
+
+    // Written whole, a crash leaves the previous store behind
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "Failed to open energy store:" << file.errorString();
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&m_store), sizeof(m_store));
+
+    if (!file.commit())
+    {
+        qDebug() << "Failed to write energy store:" << file.errorString();
+        return false;
+    }
+
+    m_dirty = false;
+    return true;
+}
+
+void EnergyAccountant::setMaxGap(int64_t maxGap)
+{
+    m_maxGap = maxGap;
+}
+
+void EnergyAccountant::setSaveInterval(int64_t saveInterval)
+{
+    m_saveInterval = saveInterval;
+}
+
+void EnergyAccountant::addSample(int64_t timestamp, float power, const QString& preset)
+{
+    int64_t elapsed = timestamp - m_lastTimestamp;
+
+    if (m_lastSlot >= 0 && elapsed > 0 && elapsed <= m_maxGap)
+    {
+        double duration = elapsed / 1000.0;
+        double energy = (m_lastPower + power) * 0.5 * duration;
+        float peakPower = std::max(m_lastPower, power);
+
+        addTotals(m_session[m_lastSlot], energy, duration, peakPower);
+        addTotals(daySlot(timestamp).totals[m_lastSlot], energy, duration, peakPower);
+
+        m_dirty = true;
+    }
+
+    // The slot lookup compares names, so it is cached across samples
+    if (m_lastSlot < 0 || preset != m_lastPreset)
+    {
+        m_lastPreset = preset;
+        m_lastSlot = presetSlot(preset);
+    }
+
+    m_lastTimestamp = timestamp;
+    m_lastPower = power;
+
+    if (timestamp - m_lastSave >= m_saveInterval)
+    {
+        m_lastSave = timestamp;
+        save();
+    }
+}
+
+EnergyTotals EnergyAccountant::sessionTotals(const QString& preset) const
+{
+    for (int32_t i = 0; i < MaxPresets; ++i)
+    {
+        if (preset == QString::fromUtf8(m_store.presets[i]))
+            return m_session[i];
+    }
+
+    return EnergyTotals();
+}
+
+EnergyTotals EnergyAccountant::todayTotals(const QString& preset) const
+{
+    int64_t today = localDay(QDateTime::currentMSecsSinceEpoch());
+
+    const Day& day = m_store.days[today % Days];
+    if (day.day != today)
+        return EnergyTotals();
+
+    for (int32_t i = 0; i < MaxPresets; ++i)
+    {
+        if (preset == QString::fromUtf8(m_store.presets[i]))
+            return day.totals[i];
+    }
+
+    return EnergyTotals();
+}
+
+QString EnergyAccountant::report() const
+{
+    QString text;
+    QTextStream out(&text);
+
+    const Day* days[Days];
+    int32_t count = 0;
+
+    for (const Day& day : m_store.days)
+    {
+        if (day.day >= 0)
+            days[count++] = &day;
+    }
+
+    std::sort(days, days + count, [](const Day* a, const Day* b) { return a->day < b->day; });
+
+    for (int32_t i = 0; i < count; ++i)
+    {
+        out << QDate::fromJulianDay(days[i]->day).toString(Qt::ISODate) << Qt::endl;
+
+        for (int32_t slot = 0; slot < MaxPresets; ++slot)
+            writeTotals(out, m_store.presets[slot], days[i]->totals[slot]);
+    }
+
+    out << "session" << Qt::endl;
+
+    for (int32_t slot = 0; slot < MaxPresets; ++slot)
+        writeTotals(out, m_store.presets[slot], m_session[slot]);
+
+    return text;
+}
+
+int32_t EnergyAccountant::presetSlot(const QString& preset)
+{
+    QByteArray name = preset.toUtf8().left(NameSize - 1);
+
+    for (int32_t i = 0; i < MaxPresets; ++i)
+    {
+        if (std::strncmp(m_store.presets[i], name.constData(), NameSize) == 0)
+            return i;
+    }
+
+    for (int32_t i = 0; i < MaxPresets; ++i)
+    {
+        if (m_store.presets[i][0] == '\0')
+        {
+            std::memcpy(m_store.presets[i], name.constData(), name.size());
+            m_dirty = true;
+            return i;
+        }
+    }
+
+    // Full, the slot of the preset with the least energy in the ring is reused
+    int32_t slot = 0;
+    double least = -1.0;
+
+    for (int32_t i = 0; i < MaxPresets; ++i)
+    {
+        double energy = 0.0;
+        for (const Day& day : m_store.days)
+            energy += day.totals[i].energy;
+
+        if (least < 0.0 || energy < least)
+        {
+            least = energy;
+            slot = i;
+        }
+    }
+
+    qDebug() << "Energy store is full, reusing the slot of" << m_store.presets[slot] << "for" << preset;
+
+    std::memset(m_store.presets[slot], 0, NameSize);
+    std::memcpy(m_store.presets[slot], name.constData(), name.size());
+
+    for (Day& day : m_store.days)
+        day.totals[slot] = EnergyTotals();
+
+    m_session[slot] = EnergyTotals();
+    m_dirty = true;
+
+    return slot;
+}
+
+EnergyAccountant::Day& EnergyAccountant::daySlot(int64_t timestamp)
+{
+    if (timestamp < m_todayStart || timestamp >= m_todayEnd)
+    {
+        QDate date = QDateTime::fromMSecsSinceEpoch(timestamp).date();
+
+        m_today = date.toJulianDay();
+        m_todayStart = date.startOfDay().toMSecsSinceEpoch();
+        m_todayEnd = date.addDays(1).startOfDay().toMSecsSinceEpoch();
+    }
+
+    Day& day = m_store.days[m_today % Days];
+
+    // The oldest day in the ring makes room for today
+    if (day.day != m_today)
+    {
+        day = Day();
+        day.day = m_today;
+    }
+
+    return day;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QString>
+
+#include <cstdint>
+
+// Energy spent in one preset over a day or a session
+struct EnergyTotals
+{
+    double energy = 0.0;
+    double duration = 0.0;
+    float peakPower = 0.0f;
+    float reserved = 0.0f;
+};
+
+// Integrates the socket power per active preset with the trapezoidal rule, so
+// irregular watchdog ticks are weighted by their real spacing. Everything is
+// fixed size: up to MaxPresets presets and a ring of the last Days days, which
+// is also the on-disk format, so the file never grows.
+class EnergyAccountant
+{
+public:
+    static constexpr int32_t MaxPresets = 16;
+    static constexpr int32_t Days = 31;
+    static constexpr int32_t NameSize = 32;
+
+    EnergyAccountant();
+    ~EnergyAccountant();
+
+    bool load(const QString& filePath);
+    bool save();
+
+    // Samples further apart than maxGap (ms), e.g. across a suspend, only restart the integration
+    void setMaxGap(int64_t maxGap);
+    void setSaveInterval(int64_t saveInterval);
+
+    // timestamp in ms since the epoch, power in W, the preset active until now
+    void addSample(int64_t timestamp, float power, const QString& preset);
+
+    EnergyTotals sessionTotals(const QString& preset) const;
+    EnergyTotals todayTotals(const QString& preset) const;
+
+    // One block per stored day and one for the session, Wh, time, average and peak W
+    QString report() const;
+
+private:
+    struct Day
+    {
+        int64_t day = -1;
+        EnergyTotals totals[MaxPresets];
+    };
+
+    struct Store
+    {
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        char presets[MaxPresets][NameSize] = {};
+        Day days[Days];
+    };
+
+    int32_t presetSlot(const QString& preset);
+    Day& daySlot(int64_t timestamp);
+
+    Store m_store;
+    EnergyTotals m_session[MaxPresets];
+
+    QString m_filePath;
+
+    QString m_lastPreset;
+    int32_t m_lastSlot = -1;
+    int64_t m_lastTimestamp = 0;
+    float m_lastPower = 0.0f;
+
+    // Bounds of the local day of the last sample, the time zone lookup is not free
+    int64_t m_today = -1;
+    int64_t m_todayStart = 0;
+    int64_t m_todayEnd = 0;
+
+    int64_t m_maxGap = 60000;
+    int64_t m_saveInterval = 600000;
+    int64_t m_lastSave = 0;
+    bool m_dirty = false;
+};
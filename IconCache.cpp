@@ -0,0 +1,52 @@
+#include "IconCache.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QPixmap>
+
+IconCache::IconCache()
+{
+}
+
+IconCache::~IconCache()
+{
+}
+
+void IconCache::preload(const QStringList& names)
+{
+    for (const QString& name : names)
+        icon(name);
+}
+
+const QIcon& IconCache::icon(const QString& name)
+{
+    auto it = m_icons.find(name);
+    if (it == m_icons.end())
+        it = m_icons.insert(name, loadIcon(name));
+
+    return it.value();
+}
+
+QIcon IconCache::loadIcon(const QString& name) const
+{
+    QString fileName = QString("Resources/%1.png").arg(name);
+
+    QString overridePath = QDir(QCoreApplication::applicationDirPath()).filePath(fileName);
+    if (QFileInfo::exists(overridePath))
+    {
+        QPixmap pixmap(overridePath);
+        if (!pixmap.isNull())
+            return QIcon(pixmap);
+
+        qDebug() << "Failed to load icon:" << overridePath;
+    }
+
+    // QIcon(fileName) would decode lazily on first paint, the pixmap is decoded now
+    QPixmap pixmap(":/" + fileName);
+    if (pixmap.isNull())
+        pixmap.load(":/Resources/Default.png");
+
+    return QIcon(pixmap);
+}
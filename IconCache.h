@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QHash>
+#include <QIcon>
+#include <QString>
+#include <QStringList>
+
+// Icons decoded once and kept for the whole session. The icons compiled into
+// the binary can be overridden by Resources/<name>.png next to the executable.
+class IconCache
+{
+public:
+    IconCache();
+    ~IconCache();
+
+    void preload(const QStringList& names);
+
+    const QIcon& icon(const QString& name);
+
+private:
+    QIcon loadIcon(const QString& name) const;
+
+    QHash<QString, QIcon> m_icons;
+};
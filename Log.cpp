@@ -0,0 +1,263 @@
+#include "Log.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <chrono>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+constexpr uint32_t g_ringSize = 1024;
+
+static const char* const g_categoryNames[] =
+{
+    "engine",
+    "apply",
+    "config",
+};
+
+static const char* const g_eventFormats[] =
+{
+    "Preset %s activated",
+    "Applied %s: %d",
+    "SMU rejected %s: %d, error %d",
+    "Apply finished in %d us",
+    "Hold %s applied in %d us",
+    "Hold released, %s restored in %d us",
+    "Limits drifted from %s, fast %f slow %f",
+    "Presets read, %d presets",
+    "Presets written",
+    "cpufreq rejected %s on policy %d, errno %d",
+    "Load phase %s, ipc %f mpki %f",
+    "EPP %s rejected, not in energy_performance_available_preferences",
+};
+
+static_assert(std::size(g_categoryNames) == static_cast<size_t>(LogCategory::Count));
+static_assert(std::size(g_eventFormats) == static_cast<size_t>(LogEvent::Count));
+
+// Single producer, the owning thread, and single consumer, whoever holds the
+// flush mutex. A ring released by its thread is handed to the next new thread
+// once the flusher has drained it.
+struct LogRing
+{
+    std::atomic<uint32_t> head = 0;
+    std::atomic<uint32_t> tail = 0;
+    std::atomic<uint64_t> dropped = 0;
+    std::atomic<bool> released = false;
+    std::atomic<uint32_t> thread = 0;
+    LogRecord records[g_ringSize];
+};
+
+// Releases the ring of a thread when the thread exits
+struct LogRingOwner
+{
+    LogRing* ring = nullptr;
+
+    ~LogRingOwner()
+    {
+        if (ring != nullptr)
+            ring->released.store(true, std::memory_order_release);
+    }
+};
+
+std::atomic<uint32_t> Log::s_enabled = 0xFFFFFFFFu;
+
+static QMutex g_ringsMutex;
+static std::vector<std::unique_ptr<LogRing>> g_rings;
+static uint32_t g_threadCount = 0;
+static std::atomic<uint64_t> g_dropped = 0;
+
+static QMutex g_flushMutex;
+static QWaitCondition g_flushCondition;
+static QThread* g_flushThread = nullptr;
+static bool g_stopping = false;
+
+static thread_local LogRingOwner t_owner;
+
+static LogRing* threadRing()
+{
+    if (t_owner.ring != nullptr)
+        return t_owner.ring;
+
+    // Once per thread. Rings outlive their threads, the flusher may still
+    // have records of them to format, so only drained ones are reused. Pool
+    // threads come and go, they would add a ring each otherwise.
+    QMutexLocker locker(&g_ringsMutex);
+
+    LogRing* ring = nullptr;
+    for (const auto& candidate : g_rings)
+    {
+        if (candidate->released.load(std::memory_order_acquire)
+            && candidate->tail.load(std::memory_order_acquire) == candidate->head.load(std::memory_order_relaxed))
+        {
+            ring = candidate.get();
+            break;
+        }
+    }
+
+    if (ring == nullptr)
+    {
+        g_rings.push_back(std::make_unique<LogRing>());
+        ring = g_rings.back().get();
+    }
+
+    ring->released.store(false, std::memory_order_relaxed);
+    ring->thread.store(++g_threadCount, std::memory_order_relaxed);
+    t_owner.ring = ring;
+
+    return ring;
+}
+
+static QByteArray formatRecord(const LogRecord& record)
+{
+    QByteArray line = QDateTime::fromMSecsSinceEpoch(record.timestamp / 1000000).toString("hh:mm:ss.zzz").toLatin1();
+    line += ' ';
+    line += g_categoryNames[static_cast<size_t>(record.category)];
+    line += ": ";
+
+    int32_t arg = 0;
+    for (const char* format = g_eventFormats[static_cast<size_t>(record.event)]; *format != '\0'; ++format)
+    {
+        if (format[0] != '%' || format[1] == '\0')
+        {
+            line += *format;
+            continue;
+        }
+
+        ++format;
+
+        if (*format == 's')
+        {
+            line += record.text;
+        }
+        else if (*format == 'd' && arg < record.argCount)
+        {
+            line += QByteArray::number(static_cast<qlonglong>(record.args[arg++]));
+        }
+        else if (*format == 'f' && arg < record.argCount)
+        {
+            double number;
+            std::memcpy(&number, &record.args[arg++], sizeof(number));
+            line += QByteArray::number(number, 'f', 2);
+        }
+    }
+
+    return line;
+}
+
+static void drainRings()
+{
+    std::vector<LogRing*> rings;
+    {
+        QMutexLocker locker(&g_ringsMutex);
+        for (const auto& ring : g_rings)
+            rings.push_back(ring.get());
+    }
+
+    for (LogRing* ring : rings)
+    {
+        uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint32_t head = ring->head.load(std::memory_order_acquire);
+
+        for (; tail != head; ++tail)
+            qDebug().noquote() << formatRecord(ring->records[tail % g_ringSize]);
+
+        ring->tail.store(tail, std::memory_order_release);
+
+        if (uint64_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed))
+            qDebug() << "Log ring" << ring->thread.load(std::memory_order_relaxed) << "dropped" << dropped << "records";
+    }
+}
+
+void Log::setEnabled(LogCategory category, bool enabled)
+{
+    uint32_t bit = 1u << static_cast<uint32_t>(category);
+
+    if (enabled)
+        s_enabled.fetch_or(bit, std::memory_order_relaxed);
+    else
+        s_enabled.fetch_and(~bit, std::memory_order_relaxed);
+}
+
+void Log::start(int32_t interval)
+{
+    QMutexLocker locker(&g_flushMutex);
+
+    if (g_flushThread != nullptr)
+        return;
+
+    g_stopping = false;
+    g_flushThread = QThread::create([interval]()
+    {
+        QMutexLocker locker(&g_flushMutex);
+
+        while (!g_stopping)
+        {
+            g_flushCondition.wait(&g_flushMutex, static_cast<unsigned long>(interval));
+            drainRings();
+        }
+    });
+
+    g_flushThread->setObjectName("Log flusher");
+    g_flushThread->start(QThread::LowPriority);
+}
+
+void Log::stop()
+{
+    {
+        QMutexLocker locker(&g_flushMutex);
+
+        if (g_flushThread == nullptr)
+            return;
+
+        g_stopping = true;
+        g_flushCondition.wakeAll();
+    }
+
+    g_flushThread->wait();
+    delete g_flushThread;
+    g_flushThread = nullptr;
+
+    flush();
+}
+
+void Log::flush()
+{
+    QMutexLocker locker(&g_flushMutex);
+    drainRings();
+}
+
+uint64_t Log::dropped()
+{
+    // The rings only count what the flusher has not reported yet
+    return g_dropped.load(std::memory_order_relaxed);
+}
+
+int64_t Log::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void Log::append(const LogRecord& record)
+{
+    LogRing* ring = threadRing();
+
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= g_ringSize)
+    {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    LogRecord& slot = ring->records[head % g_ringSize];
+    slot = record;
+    slot.thread = ring->thread.load(std::memory_order_relaxed);
+
+    ring->head.store(head + 1, std::memory_order_release);
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <QString>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Categories compiled in, one bit per LogCategory. Building with e.g.
+// -DREDMIOSD_LOG_CATEGORIES=0 removes every REDMIOSD_LOG call from the binary.
+#ifndef REDMIOSD_LOG_CATEGORIES
+#define REDMIOSD_LOG_CATEGORIES 0xFFFFFFFFu
+#endif
+
+enum class LogCategory : uint8_t
+{
+    Engine,
+    Apply,
+    Config,
+    Count
+};
+
+// Each event has a format in Log.cpp, %s takes the text, %d and %f the args
+enum class LogEvent : uint16_t
+{
+    PresetActivated,
+    ApplyArg,
+    ApplyFailed,
+    ApplyFinished,
+    HoldApplied,
+    HoldReleased,
+    LimitsDrifted,
+    PresetsRead,
+    PresetsWritten,
+    CpufreqFailed,
+    LoadPhaseChanged,
+    EppRejected,
+    Count
+};
+
+// Fixed size, written by the logging thread and formatted by the flusher
+struct LogRecord
+{
+    int64_t timestamp;
+    LogEvent event;
+    LogCategory category;
+    uint8_t argCount;
+    uint32_t thread;
+    char text[32];
+    int64_t args[2];
+};
+
+static_assert(sizeof(LogRecord) == 64, "LogRecord should fill one cache line");
+
+// Binary event log. Every thread writes into a ring of its own without locks,
+// a background thread formats the records and hands them to qDebug. Records
+// are dropped, and counted, while a ring is full.
+class Log
+{
+public:
+    static constexpr bool isCompiled(LogCategory category)
+    {
+        return (static_cast<uint32_t>(REDMIOSD_LOG_CATEGORIES) >> static_cast<uint32_t>(category)) & 1u;
+    }
+
+    static bool isEnabled(LogCategory category)
+    {
+        return (s_enabled.load(std::memory_order_relaxed) >> static_cast<uint32_t>(category)) & 1u;
+    }
+
+    static void setEnabled(LogCategory category, bool enabled);
+
+    // Starts the flusher, without it records wait for flush()
+    static void start(int32_t interval = 200);
+    static void stop();
+    static void flush();
+
+    static uint64_t dropped();
+
+    template<typename... Args>
+    static void write(LogCategory category, LogEvent event, const Args&... args)
+    {
+        static_assert(sizeof...(Args) <= 3, "A record holds one text and two args");
+
+        LogRecord record;
+        record.timestamp = now();
+        record.event = event;
+        record.category = category;
+        record.argCount = 0;
+        record.text[0] = '\0';
+        (store(record, args), ...);
+
+        append(record);
+    }
+
+private:
+    static int64_t now();
+    static void append(const LogRecord& record);
+
+    static void store(LogRecord& record, const char* text)
+    {
+        std::strncpy(record.text, text, sizeof(record.text) - 1);
+        record.text[sizeof(record.text) - 1] = '\0';
+    }
+
+    static void store(LogRecord& record, const QString& text)
+    {
+        // No conversion to a QByteArray, that would allocate
+        qsizetype length = std::min<qsizetype>(text.size(), sizeof(record.text) - 1);
+        for (qsizetype i = 0; i < length; ++i)
+            record.text[i] = text[i].toLatin1();
+
+        record.text[length] = '\0';
+    }
+
+    template<typename Value>
+    static std::enable_if_t<std::is_arithmetic_v<Value>> store(LogRecord& record, Value value)
+    {
+        if (record.argCount >= 2) return;
+
+        if constexpr (std::is_floating_point_v<Value>)
+        {
+            double number = value;
+            std::memcpy(&record.args[record.argCount++], &number, sizeof(number));
+        }
+        else
+        {
+            record.args[record.argCount++] = static_cast<int64_t>(value);
+        }
+    }
+
+    static std::atomic<uint32_t> s_enabled;
+};
+
+// Disabled at compile time the call is gone, disabled at runtime it costs the
+// load of the enabled mask and one branch
+#define REDMIOSD_LOG(category, ...) \
+    do \
+    { \
+        if constexpr (Log::isCompiled(LogCategory::category)) \
+        { \
+            if (Log::isEnabled(LogCategory::category)) \
+                Log::write(LogCategory::category, __VA_ARGS__); \
+        } \
+    } while (false)
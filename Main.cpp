@@ -1,16 +1,29 @@
 #include <QApplication>
+#include <QDebug>
+#include <QElapsedTimer>
 #include <QMessageBox>
-#include <QSharedMemory>
+#include "CommandLine.h"
+#include "ControlClient.h"
+#include "Log.h"
+#include "ProcessStats.h"
 #include "RedmiOSD.h"
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
+    if (hasCommandLine(argc, argv))
+    {
+        QCoreApplication app(argc, argv);
+        return runCommandLine(app);
+    }
+
     QApplication app(argc, argv);
     
-    const QString memKey = "RedmiOSDSharedMemoryKey";
-    QSharedMemory sharedMemory(memKey);
+    ControlClient client;
 
-    if (!sharedMemory.create(1))
+    if (client.connectToServer())
     {
         QMessageBox::critical(nullptr, QObject::tr("RedmiOSD"), QObject::tr("Another instance of RedmiOSD is already running."));
         return 1;
@@ -23,6 +36,28 @@ int main(int argc, char *argv[])
     }
     QApplication::setQuitOnLastWindowClosed(false);
 
+    Log::start();
+
     RedmiOSD osd;
-    return app.exec();
+
+    if (reportStartupProbe(startupTimer.elapsed()))
+    {
+        Log::stop();
+        return 0;
+    }
+
+    if (!osd.start())
+    {
+        QMessageBox::critical(nullptr, QObject::tr("RedmiOSD"), QObject::tr("Failed to listen on the control socket, another instance of RedmiOSD may be running."));
+        Log::stop();
+        return 1;
+    }
+
+    qInfo() << "Started in" << startupTimer.elapsed() << "ms, RSS" << residentMemory() << "KiB";
+
+    int result = app.exec();
+
+    Log::stop();
+
+    return result;
 }
\ No newline at end of file
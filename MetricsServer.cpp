@@ -0,0 +1,215 @@
+#include "MetricsServer.h"
+
+#include <QDebug>
+#include <QList>
+#include <QTcpSocket>
+
+#include <cstdarg>
+#include <cstdio>
+
+#include "PresetEngine.h"
+
+static const char* g_errorNames[EngineStats::ErrorCodes] =
+{
+    "ADJ_ERR_FAM_UNSUPPORTED",
+    "ADJ_ERR_SMU_TIMEOUT",
+    "ADJ_ERR_SMU_UNSUPPORTED",
+    "ADJ_ERR_SMU_REJECTED",
+    "ADJ_ERR_MEMORY_ACCESS",
+    "OTHER",
+};
+
+// Preset names come from Presets.json, a quote or newline in one would end the
+// label value early
+static QByteArray labelValue(const QString& value)
+{
+    QByteArray label = value.toUtf8();
+    label.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+    return label;
+}
+
+static const QByteArray g_notFound = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+MetricsServer::MetricsServer(PresetEngine& engine, QObject* parent)
+    : QObject(parent)
+    , m_engine(engine)
+{
+    m_body.reserve(8192);
+    m_response.reserve(8192);
+
+    connect(&m_server, &QTcpServer::newConnection, this, &MetricsServer::newConnection);
+}
+
+MetricsServer::~MetricsServer()
+{
+    stop();
+}
+
+bool MetricsServer::listen(quint16 port)
+{
+    if (!m_server.listen(QHostAddress::LocalHost, port))
+    {
+        qDebug() << "Failed to listen on metrics port:" << m_server.errorString();
+        return false;
+    }
+
+    // Only render while listening, the engine ticks without metrics enabled too
+    connect(&m_engine, &PresetEngine::telemetryUpdated, this, &MetricsServer::render, Qt::UniqueConnection);
+    connect(&m_engine, &PresetEngine::presetActivated, this, &MetricsServer::render, Qt::UniqueConnection);
+
+    render();
+    return true;
+}
+
+void MetricsServer::stop()
+{
+    disconnect(&m_engine, &PresetEngine::telemetryUpdated, this, &MetricsServer::render);
+    disconnect(&m_engine, &PresetEngine::presetActivated, this, &MetricsServer::render);
+
+    m_server.close();
+}
+
+quint16 MetricsServer::serverPort() const
+{
+    return m_server.serverPort();
+}
+
+void MetricsServer::newConnection()
+{
+    while (QTcpSocket* socket = m_server.nextPendingConnection())
+    {
+        connect(socket, &QTcpSocket::readyRead, this, &MetricsServer::socketReadyRead);
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void MetricsServer::socketReadyRead()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    if (socket == nullptr) return;
+
+    QByteArray request = socket->peek(socket->bytesAvailable());
+    if (!request.contains("\r\n\r\n"))
+    {
+        if (request.size() > 8192)
+            socket->abort();
+
+        return;
+    }
+
+    socket->readAll();
+
+    // Both buffers are implicitly shared, writing them does not copy
+    if (request.startsWith("GET /metrics ") || request.startsWith("GET / "))
+        socket->write(m_response);
+    else
+        socket->write(g_notFound);
+
+    socket->disconnectFromHost();
+}
+
+void MetricsServer::render()
+{
+    const Telemetry& telemetry = m_engine.telemetry();
+    const EngineStats& stats = m_engine.stats();
+
+    m_body.resize(0);
+
+    append("# HELP redmiosd_socket_power_watts Socket power.\n# TYPE redmiosd_socket_power_watts gauge\n");
+    append("redmiosd_socket_power_watts %g\n", telemetry.socketPower);
+
+    append("# HELP redmiosd_tctl_celsius Tctl temperature.\n# TYPE redmiosd_tctl_celsius gauge\n");
+    append("redmiosd_tctl_celsius %g\n", telemetry.tctlTemp);
+
+    append("# HELP redmiosd_stapm_watts STAPM value.\n# TYPE redmiosd_stapm_watts gauge\n");
+    append("redmiosd_stapm_watts %g\n", telemetry.stapmValue);
+
+    append("# HELP redmiosd_stapm_limit_watts STAPM limit.\n# TYPE redmiosd_stapm_limit_watts gauge\n");
+    append("redmiosd_stapm_limit_watts %g\n", telemetry.stapmLimit);
+
+    append("# HELP redmiosd_core_clock_hertz Core clock.\n# TYPE redmiosd_core_clock_hertz gauge\n");
+    for (int32_t i = 0; i < telemetry.coreCount; ++i)
+        append("redmiosd_core_clock_hertz{core=\"%d\"} %g\n", i, telemetry.coreClocks[i] * 1e9);
+
+    append("# HELP redmiosd_active_preset Active preset.\n# TYPE redmiosd_active_preset gauge\n");
+    const Presets& presets = m_engine.presets();
+
+    QList<QByteArray> labels;
+    labels.reserve(presets.argsMap.size());
+    for (auto it = presets.argsMap.constBegin(); it != presets.argsMap.constEnd(); ++it)
+        labels.append(labelValue(it.key()));
+
+    int32_t index = 0;
+    for (auto it = presets.argsMap.constBegin(); it != presets.argsMap.constEnd(); ++it)
+        append("redmiosd_active_preset{preset=\"%s\"} %d\n", labels[index++].constData(), it.key() == m_engine.activePreset() ? 1 : 0);
+
+    append("# HELP redmiosd_apply_duration_seconds Duration of preset applies.\n# TYPE redmiosd_apply_duration_seconds histogram\n");
+    uint64_t count = 0;
+    for (int32_t i = 0; i < EngineStats::LatencyBuckets - 1; ++i)
+    {
+        count += stats.applyLatency[i];
+        append("redmiosd_apply_duration_seconds_bucket{le=\"%g\"} %llu\n", EngineStats::LatencyBounds[i] / 1000.0, static_cast<unsigned long long>(count));
+    }
+    append("redmiosd_apply_duration_seconds_bucket{le=\"+Inf\"} %llu\n", static_cast<unsigned long long>(stats.applyCount));
+    append("redmiosd_apply_duration_seconds_sum %g\n", stats.applyLatencySum / 1000.0);
+    append("redmiosd_apply_duration_seconds_count %llu\n", static_cast<unsigned long long>(stats.applyCount));
+
+    append("# HELP redmiosd_smu_errors_total Failed SMU requests by ryzenadj error code.\n# TYPE redmiosd_smu_errors_total counter\n");
+    for (int32_t i = 0; i < EngineStats::ErrorCodes; ++i)
+        append("redmiosd_smu_errors_total{code=\"%s\"} %llu\n", g_errorNames[i], static_cast<unsigned long long>(stats.smuErrors[i]));
+
+    append("# HELP redmiosd_drift_events_total Limits reset behind our back and reapplied.\n# TYPE redmiosd_drift_events_total counter\n");
+    append("redmiosd_drift_events_total %llu\n", static_cast<unsigned long long>(stats.driftEvents));
+
+    append("# HELP redmiosd_watchdog_wakeups_total Watchdog ticks.\n# TYPE redmiosd_watchdog_wakeups_total counter\n");
+    append("redmiosd_watchdog_wakeups_total %llu\n", static_cast<unsigned long long>(stats.watchdogWakeups));
+
+    if (presets.energy.enabled)
+    {
+        append("# HELP redmiosd_energy_joules_total Socket energy spent per preset since startup.\n# TYPE redmiosd_energy_joules_total counter\n");
+        index = 0;
+        for (auto it = presets.argsMap.constBegin(); it != presets.argsMap.constEnd(); ++it)
+            append("redmiosd_energy_joules_total{preset=\"%s\"} %g\n", labels[index++].constData(), m_engine.energy().sessionTotals(it.key()).energy);
+
+        append("# HELP redmiosd_preset_seconds_total Time spent per preset since startup.\n# TYPE redmiosd_preset_seconds_total counter\n");
+        index = 0;
+        for (auto it = presets.argsMap.constBegin(); it != presets.argsMap.constEnd(); ++it)
+            append("redmiosd_preset_seconds_total{preset=\"%s\"} %g\n", labels[index++].constData(), m_engine.energy().sessionTotals(it.key()).duration);
+    }
+
+    char header[160];
+    int size = std::snprintf(header, sizeof(header),
+        "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", static_cast<int>(m_body.size()));
+
+    m_response.resize(0);
+    m_response.append(header, size);
+    m_response.append(m_body);
+}
+
+void MetricsServer::append(const char* format, ...)
+{
+    char line[256];
+
+    va_list args;
+    va_start(args, format);
+
+    va_list retryArgs;
+    va_copy(retryArgs, args);
+
+    int size = std::vsnprintf(line, sizeof(line), format, args);
+
+    // Only a long preset name gets here, cut short the line would lose its newline
+    if (size >= static_cast<int>(sizeof(line)))
+    {
+        QByteArray longLine(size, '\0');
+        std::vsnprintf(longLine.data(), longLine.size() + 1, format, retryArgs);
+        m_body.append(longLine);
+    }
+    else if (size > 0)
+    {
+        m_body.append(line, size);
+    }
+
+    va_end(retryArgs);
+    va_end(args);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QTcpServer>
+
+class PresetEngine;
+
+// Localhost only HTTP endpoint serving telemetry and engine counters in the
+// Prometheus text format. The response is rendered once per watchdog tick into
+// a reused buffer, a scrape only writes that buffer out.
+class MetricsServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MetricsServer(PresetEngine& engine, QObject* parent = nullptr);
+    virtual ~MetricsServer();
+
+    bool listen(quint16 port);
+    void stop();
+
+    // The port actually bound, listen(0) picks a free one
+    quint16 serverPort() const;
+
+private slots:
+    void newConnection();
+    void socketReadyRead();
+    void render();
+
+private:
+    void append(const char* format, ...);
+
+    PresetEngine& m_engine;
+    QTcpServer m_server;
+
+    QByteArray m_body;
+    QByteArray m_response;
+};
@@ -0,0 +1,95 @@
+#include "OverlayWindow.h"
+
+#include <QFont>
+#include <QPainter>
+#include <QScreen>
+
+constexpr int32_t g_overlaySize = 200;
+constexpr int32_t g_overlayTimeout = 1000;
+
+OverlayWindow::OverlayWindow(QWidget* parent)
+    : QWidget(parent, Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint | Qt::Tool | Qt::WindowDoesNotAcceptFocus)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setAttribute(Qt::WA_TranslucentBackground);
+    setAttribute(Qt::WA_ShowWithoutActivating);
+    setFixedSize(g_overlaySize, g_overlaySize);
+
+    m_hideTimer.setSingleShot(true);
+    connect(&m_hideTimer, &QTimer::timeout, this, &QWidget::hide);
+}
+
+OverlayWindow::~OverlayWindow()
+{
+}
+
+void OverlayWindow::preload(const QStringList& messages)
+{
+    for (const QString& message : messages)
+    {
+        renderMessage(message, false);
+        renderMessage(message, true);
+    }
+}
+
+void OverlayWindow::showMessage(const QString& message, bool failed)
+{
+    m_pixmap = renderMessage(message, failed);
+
+    if (!isVisible())
+    {
+        if (QScreen* screen = this->screen())
+            move(screen->availableGeometry().center() - rect().center());
+
+        show();
+    }
+
+    // Painted right away, the caller usually blocks on the SMU next
+    repaint();
+
+    m_hideTimer.start(g_overlayTimeout);
+}
+
+void OverlayWindow::paintEvent(QPaintEvent* event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawPixmap(0, 0, m_pixmap);
+}
+
+const QPixmap& OverlayWindow::renderMessage(const QString& message, bool failed)
+{
+    auto it = m_pixmaps.find({ message, failed });
+    if (it != m_pixmaps.end())
+        return it.value();
+
+    qreal ratio = devicePixelRatioF();
+
+    QPixmap pixmap(QSize(g_overlaySize, g_overlaySize) * ratio);
+    pixmap.setDevicePixelRatio(ratio);
+    pixmap.fill(failed ? QColor(150, 0, 0, 150) : QColor(0, 0, 0, 150));
+
+    QPainter painter(&pixmap);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    painter.setPen(Qt::white);
+
+    QFont font = painter.font();
+    font.setPointSize(24);
+    painter.setFont(font);
+
+    QRect area(0, 0, g_overlaySize, g_overlaySize);
+    painter.drawText(area, Qt::AlignCenter, message);
+
+    if (failed)
+    {
+        font.setPointSize(12);
+        painter.setFont(font);
+        painter.drawText(area.adjusted(0, 0, 0, -16), Qt::AlignHCenter | Qt::AlignBottom, "Apply failed");
+    }
+
+    painter.end();
+
+    return m_pixmaps.insert({ message, failed }, pixmap).value();
+}
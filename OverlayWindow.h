@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QHash>
+#include <QPair>
+#include <QPixmap>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QWidget>
+
+// Frameless OSD created once per session. Every message is rendered into a
+// pixmap the first time it is needed, showing it again only swaps the pixmap
+// and restarts the hide timer.
+class OverlayWindow : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit OverlayWindow(QWidget* parent = nullptr);
+    virtual ~OverlayWindow();
+
+    void preload(const QStringList& messages);
+    void showMessage(const QString& message, bool failed = false);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    const QPixmap& renderMessage(const QString& message, bool failed);
+
+    QHash<QPair<QString, bool>, QPixmap> m_pixmaps;
+    QPixmap m_pixmap;
+
+    QTimer m_hideTimer;
+};
@@ -0,0 +1,149 @@
+#include "PerfCounters.h"
+
+#include <QDebug>
+#include <QtGlobal>
+
+#ifdef Q_OS_LINUX
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <linux/perf_event.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+double PerfSample::instructionsPerCycle() const
+{
+    return cycles > 0 ? static_cast<double>(instructions) / cycles : 0.0;
+}
+
+double PerfSample::missesPerKiloInstruction() const
+{
+    return instructions > 0 ? cacheMisses * 1000.0 / instructions : 0.0;
+}
+
+#ifdef Q_OS_LINUX
+static int openCounter(uint64_t config, int32_t cpu, int groupFd)
+{
+    perf_event_attr attr = {};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.disabled = groupFd < 0 ? 1 : 0;
+    attr.exclude_hv = 1;
+
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, -1, cpu, groupFd, PERF_FLAG_FD_CLOEXEC));
+}
+#endif
+
+PerfCounters::PerfCounters()
+{
+}
+
+PerfCounters::~PerfCounters()
+{
+    close();
+}
+
+bool PerfCounters::open()
+{
+    close();
+
+#ifdef Q_OS_LINUX
+    const uint64_t configs[CounterCount] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES };
+
+    const long cpuCount = ::sysconf(_SC_NPROCESSORS_ONLN);
+    for (int32_t cpu = 0; cpu < cpuCount; ++cpu)
+    {
+        Group group;
+
+        for (int32_t counter = 0; counter < CounterCount; ++counter)
+        {
+            group.fds[counter] = openCounter(configs[counter], cpu, counter == Cycles ? -1 : group.fds[Cycles]);
+            if (group.fds[counter] < 0)
+            {
+                qDebug() << "Failed to open perf counters of CPU" << cpu << strerror(errno);
+
+                m_groups.push_back(group);
+                close();
+                return false;
+            }
+        }
+
+        m_groups.push_back(group);
+    }
+
+    for (const Group& group : m_groups)
+        ::ioctl(group.fds[Cycles], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    qDebug() << "Perf counters opened on" << m_groups.size() << "CPUs";
+    return !m_groups.empty();
+#else
+    qDebug() << "Perf counters are not supported on this platform.";
+    return false;
+#endif
+}
+
+void PerfCounters::close()
+{
+#ifdef Q_OS_LINUX
+    for (Group& group : m_groups)
+    {
+        for (int fd : group.fds)
+        {
+            if (fd >= 0)
+                ::close(fd);
+        }
+    }
+#endif
+
+    m_groups.clear();
+}
+
+bool PerfCounters::isOpen() const
+{
+    return !m_groups.empty();
+}
+
+int32_t PerfCounters::cpuCount() const
+{
+    return static_cast<int32_t>(m_groups.size());
+}
+
+bool PerfCounters::read(PerfSample& sample)
+{
+    sample = PerfSample();
+
+#ifdef Q_OS_LINUX
+    // nr, time_enabled, time_running, then one value per counter
+    uint64_t buffer[3 + CounterCount];
+
+    for (Group& group : m_groups)
+    {
+        if (::read(group.fds[Cycles], buffer, sizeof(buffer)) != sizeof(buffer) || buffer[0] != CounterCount)
+            return false;
+
+        // The PMU may be shared with other users, scale up what was multiplexed away
+        double scale = buffer[2] > 0 ? static_cast<double>(buffer[1]) / buffer[2] : 0.0;
+
+        uint64_t deltas[CounterCount];
+        for (int32_t counter = 0; counter < CounterCount; ++counter)
+        {
+            uint64_t value = static_cast<uint64_t>(buffer[3 + counter] * scale);
+            deltas[counter] = value >= group.values[counter] ? value - group.values[counter] : 0;
+            group.values[counter] = value;
+        }
+
+        sample.cycles += deltas[Cycles];
+        sample.instructions += deltas[Instructions];
+        sample.cacheMisses += deltas[CacheMisses];
+    }
+
+    return !m_groups.empty();
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Totals of all CPUs since the previous read
+struct PerfSample
+{
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cacheMisses = 0;
+
+    double instructionsPerCycle() const;
+    double missesPerKiloInstruction() const;
+};
+
+// Cycles, instructions and cache misses of every CPU, counted system wide by
+// perf_event_open. The three counters of a CPU form one group opened at start,
+// read() on the leader returns all of them (PERF_FORMAT_GROUP), so a sample is
+// one syscall per CPU. Needs CAP_PERFMON or kernel.perf_event_paranoid <= 0.
+class PerfCounters
+{
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    bool open();
+    void close();
+
+    bool isOpen() const;
+    int32_t cpuCount() const;
+
+    bool read(PerfSample& sample);
+
+private:
+    enum Counter
+    {
+        Cycles,
+        Instructions,
+        CacheMisses,
+        CounterCount
+    };
+
+    struct Group
+    {
+        int fds[CounterCount] = { -1, -1, -1 };
+        uint64_t values[CounterCount] = {};
+    };
+
+    std::vector<Group> m_groups;
+};
@@ -0,0 +1,138 @@
+#include "Platform.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QStringList>
+
+class NullPowerPlan : public PowerPlan
+{
+public:
+    void setBatterySaver(int32_t threshold) override
+    {
+        Q_UNUSED(threshold);
+    }
+};
+
+class NullStartupEntry : public StartupEntry
+{
+public:
+    bool setEnabled(bool enable) override
+    {
+        Q_UNUSED(enable);
+
+        qDebug() << "Startup entries are not supported on this platform.";
+        return false;
+    }
+};
+
+#ifdef Q_OS_WIN
+class PowercfgPowerPlan : public PowerPlan
+{
+public:
+    void setBatterySaver(int32_t threshold) override
+    {
+        QString command = QString(
+            "powercfg /setdcvalueindex SCHEME_CURRENT SUB_ENERGYSAVER ESBATTTHRESHOLD %1 && "
+            "powercfg /setdcvalueindex SCHEME_CURRENT SUB_ENERGYSAVER ESBRIGHTNESS 100 && "
+            "powercfg /setactive SCHEME_CURRENT").arg(threshold);
+
+        QProcess process;
+        process.setProcessChannelMode(QProcess::MergedChannels);
+
+        process.start("cmd.exe", QStringList() << "/C" << command);
+        process.waitForFinished(-1);
+    }
+};
+
+// A link in the Startup folder of the start menu
+class LinkStartupEntry : public StartupEntry
+{
+public:
+    explicit LinkStartupEntry(const QString& name)
+        : m_linkPath(QStandardPaths::writableLocation(QStandardPaths::ApplicationsLocation) + QDir::toNativeSeparators("/Startup/") + name + ".lnk")
+    {
+    }
+
+    bool setEnabled(bool enable) override
+    {
+        if (enable)
+            return QFile::exists(m_linkPath) || QFile::link(QCoreApplication::applicationFilePath(), m_linkPath);
+
+        return !QFile::exists(m_linkPath) || QFile::remove(m_linkPath);
+    }
+
+private:
+    QString m_linkPath;
+};
+#endif
+
+#ifdef Q_OS_LINUX
+// An XDG autostart desktop entry
+class AutostartEntry : public StartupEntry
+{
+public:
+    explicit AutostartEntry(const QString& name)
+        : m_name(name)
+        , m_filePath(QStandardPaths::writableLocation(QStandardPaths::ConfigLocation) + "/autostart/" + name + ".desktop")
+    {
+    }
+
+    bool setEnabled(bool enable) override
+    {
+        if (!enable)
+            return !QFile::exists(m_filePath) || QFile::remove(m_filePath);
+
+        QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+
+        QFile file(m_filePath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate))
+        {
+            qDebug() << "Failed to write autostart entry:" << file.errorString();
+            return false;
+        }
+
+        // Started from its own directory, Presets.json is looked up relative to it
+        QString directory = QCoreApplication::applicationDirPath();
+
+        file.write(QString(
+            "[Desktop Entry]\n"
+            "Type=Application\n"
+            "Name=%1\n"
+            "Exec=\"%2\"\n"
+            "Path=%3\n"
+            "Terminal=false\n").arg(m_name, QCoreApplication::applicationFilePath(), directory).toUtf8());
+
+        return true;
+    }
+
+private:
+    QString m_name;
+    QString m_filePath;
+};
+#endif
+
+std::unique_ptr<PowerPlan> createPowerPlan()
+{
+#ifdef Q_OS_WIN
+    return std::make_unique<PowercfgPowerPlan>();
+#else
+    return std::make_unique<NullPowerPlan>();
+#endif
+}
+
+std::unique_ptr<StartupEntry> createStartupEntry(const QString& name)
+{
+#if defined(Q_OS_WIN)
+    return std::make_unique<LinkStartupEntry>(name);
+#elif defined(Q_OS_LINUX)
+    return std::make_unique<AutostartEntry>(name);
+#else
+    Q_UNUSED(name);
+    return std::make_unique<NullStartupEntry>();
+#endif
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QString>
+
+#include <cstdint>
+#include <memory>
+
+// OS power settings next to the SMU limits, only Windows has any so far
+class PowerPlan
+{
+public:
+    virtual ~PowerPlan() = default;
+
+    virtual void setBatterySaver(int32_t threshold) = 0;
+};
+
+// Starts the application with the user session
+class StartupEntry
+{
+public:
+    virtual ~StartupEntry() = default;
+
+    virtual bool setEnabled(bool enable) = 0;
+};
+
+std::unique_ptr<PowerPlan> createPowerPlan();
+std::unique_ptr<StartupEntry> createStartupEntry(const QString& name);
@@ -0,0 +1,388 @@
+#include "PowerProfilesService.h"
+
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusError>
+#include <QDBusMessage>
+#include <QDBusMetaType>
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <utility>
+
+#include "PresetEngine.h"
+
+static const QString g_serviceName = "net.hadess.PowerProfiles";
+static const QString g_objectPath = "/net/hadess/PowerProfiles";
+
+// Lookup order when several profiles map to the same preset
+static const QStringList g_profileNames = { "balanced", "power-saver", "performance" };
+
+// The polkit actions of power-profiles-daemon, installed with it
+static const QString g_switchProfileAction = "org.freedesktop.UPower.PowerProfiles.switch-profile";
+static const QString g_holdProfileAction = "org.freedesktop.UPower.PowerProfiles.hold-profile";
+
+// The (sa{sv}) subject of CheckAuthorization
+struct PolkitSubject
+{
+    QString kind;
+    QVariantMap details;
+};
+
+Q_DECLARE_METATYPE(PolkitSubject)
+
+static QDBusArgument& operator<<(QDBusArgument& argument, const PolkitSubject& subject)
+{
+    argument.beginStructure();
+    argument << subject.kind << subject.details;
+    argument.endStructure();
+    return argument;
+}
+
+static const QDBusArgument& operator>>(const QDBusArgument& argument, PolkitSubject& subject)
+{
+    argument.beginStructure();
+    argument >> subject.kind >> subject.details;
+    argument.endStructure();
+    return argument;
+}
+
+PowerProfilesService::PowerProfilesService(PresetEngine& engine, QObject* parent)
+    : QObject(parent)
+    , m_engine(engine)
+{
+    m_serviceWatcher.setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
+
+    connect(&m_serviceWatcher, &QDBusServiceWatcher::serviceUnregistered, this, &PowerProfilesService::serviceUnregistered);
+    connect(&m_engine, &PresetEngine::presetActivated, this, &PowerProfilesService::presetActivated);
+}
+
+PowerProfilesService::~PowerProfilesService()
+{
+    if (!m_registered) return;
+
+    QDBusConnection bus(m_connectionName);
+    bus.unregisterService(g_serviceName);
+    bus.unregisterObject(g_objectPath);
+}
+
+bool PowerProfilesService::start()
+{
+    const PowerProfilesSettings& settings = m_engine.presets().powerProfiles;
+
+    QDBusConnection bus = settings.systemBus ? QDBusConnection::systemBus() : QDBusConnection::sessionBus();
+    if (!bus.isConnected())
+    {
+        qDebug() << "Failed to connect to D-Bus:" << bus.lastError().message();
+        return false;
+    }
+
+    qDBusRegisterMetaType<QList<QVariantMap>>();
+    qDBusRegisterMetaType<QMap<QString, QString>>();
+    qDBusRegisterMetaType<PolkitSubject>();
+
+    if (!bus.registerObject(g_objectPath, this, QDBusConnection::ExportScriptableContents | QDBusConnection::ExportAllProperties))
+    {
+        qDebug() << "Failed to register D-Bus object:" << g_objectPath;
+        return false;
+    }
+
+    // Fails while power-profiles-daemon itself is running
+    if (!bus.registerService(g_serviceName))
+    {
+        qDebug() << "Failed to register D-Bus service:" << bus.lastError().message();
+        bus.unregisterObject(g_objectPath);
+        return false;
+    }
+
+    m_connectionName = bus.name();
+    m_registered = true;
+    m_serviceWatcher.setConnection(bus);
+    m_activeProfile = profileForPreset(m_engine.activePreset());
+
+    qDebug() << "Power profiles service registered on the" << (settings.systemBus ? "system" : "session") << "bus.";
+    return true;
+}
+
+QString PowerProfilesService::activeProfile() const
+{
+    return m_activeProfile;
+}
+
+void PowerProfilesService::setActiveProfile(const QString& profile)
+{
+    if (!isAuthorized(g_switchProfileAction))
+        return;
+
+    QString preset = m_engine.presets().powerProfiles.profiles.value(profile);
+    if (!m_engine.presets().argsMap.contains(preset))
+    {
+        qDebug() << "Unknown power profile:" << profile;
+
+        if (calledFromDBus())
+            sendErrorReply(QDBusError::InvalidArgs, QString("Invalid profile name '%1'").arg(profile));
+
+        return;
+    }
+
+    // Choosing a profile drops all holds, like power-profiles-daemon does.
+    // The arbiter requests go away with the switch itself
+    if (!m_holds.isEmpty())
+    {
+        for (auto it = m_holds.constBegin(); it != m_holds.constEnd(); ++it)
+        {
+            m_serviceWatcher.removeWatchedService(it.value().sender);
+            emit ProfileReleased(it.key());
+        }
+
+        m_holds.clear();
+        notifyPropertyChanged("ActiveProfileHolds", QVariant::fromValue(activeProfileHolds()));
+    }
+
+    QString previousProfile = m_activeProfile;
+    m_activeProfile = profile;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    m_engine.switchPreset(preset);
+
+    qDebug() << "Power profile" << profile << "switched in" << timer.nsecsElapsed() / 1000 << "us";
+
+    if (m_activeProfile != previousProfile)
+        notifyPropertyChanged("ActiveProfile", m_activeProfile);
+}
+
+QString PowerProfilesService::performanceInhibited() const
+{
+    return QString();
+}
+
+QString PowerProfilesService::performanceDegraded() const
+{
+    return QString();
+}
+
+QList<QVariantMap> PowerProfilesService::profiles() const
+{
+    const QMap<QString, QString>& mapping = m_engine.presets().powerProfiles.profiles;
+
+    QList<QVariantMap> profiles;
+    for (const QString& name : { QString("power-saver"), QString("balanced"), QString("performance") })
+    {
+        if (!mapping.contains(name))
+            continue;
+
+        profiles.append({ { "Profile", name }, { "Driver", "redmiosd" }, { "PlatformDriver", "redmiosd" } });
+    }
+
+    return profiles;
+}
+
+QStringList PowerProfilesService::actions() const
+{
+    return QStringList();
+}
+
+QList<QVariantMap> PowerProfilesService::activeProfileHolds() const
+{
+    QList<QVariantMap> holds;
+    for (const Hold& hold : m_holds)
+        holds.append({ { "Profile", hold.profile }, { "Reason", hold.reason }, { "ApplicationId", hold.applicationId } });
+
+    return holds;
+}
+
+QString PowerProfilesService::version() const
+{
+    // Version of power-profiles-daemon whose interface is implemented
+    return "0.20";
+}
+
+uint PowerProfilesService::HoldProfile(const QString& profile, const QString& reason, const QString& applicationId)
+{
+    if (!isAuthorized(g_holdProfileAction))
+        return 0;
+
+    if ((profile != "performance" && profile != "power-saver") || !m_engine.presets().powerProfiles.profiles.contains(profile))
+    {
+        if (calledFromDBus())
+            sendErrorReply(QDBusError::InvalidArgs, QString("Only profiles 'performance' and 'power-saver' can be a hold"));
+
+        return 0;
+    }
+
+    uint cookie = m_nextCookie++;
+
+    Hold hold;
+    hold.profile = profile;
+    hold.reason = reason;
+    hold.applicationId = applicationId;
+
+    if (calledFromDBus())
+    {
+        hold.sender = message().service();
+
+        if (!m_serviceWatcher.watchedServices().contains(hold.sender))
+            m_serviceWatcher.addWatchedService(hold.sender);
+    }
+
+    m_holds.insert(cookie, hold);
+
+    qDebug() << "Power profile hold" << cookie << profile << "by" << applicationId << ":" << reason;
+
+    updateHolds();
+    return cookie;
+}
+
+void PowerProfilesService::ReleaseProfile(uint cookie)
+{
+    if (!m_holds.contains(cookie))
+    {
+        if (calledFromDBus())
+            sendErrorReply(QDBusError::InvalidArgs, QString("No hold with cookie %1").arg(cookie));
+
+        return;
+    }
+
+    // Only the application that took a hold gives it back
+    if (calledFromDBus() && m_holds[cookie].sender != message().service())
+    {
+        sendErrorReply(QDBusError::AccessDenied, QString("Hold %1 belongs to another application").arg(cookie));
+        return;
+    }
+
+    releaseHold(cookie);
+    updateHolds();
+}
+
+void PowerProfilesService::presetActivated(const QString& preset)
+{
+    QString profile = profileForPreset(preset);
+    if (profile == m_activeProfile)
+        return;
+
+    m_activeProfile = profile;
+    notifyPropertyChanged("ActiveProfile", m_activeProfile);
+}
+
+void PowerProfilesService::serviceUnregistered(const QString& service)
+{
+    // Holds end with the application that took them
+    bool released = false;
+    for (uint cookie : m_holds.keys())
+    {
+        if (m_holds[cookie].sender == service)
+        {
+            releaseHold(cookie);
+            released = true;
+        }
+    }
+
+    if (released)
+        updateHolds();
+}
+
+bool PowerProfilesService::isAuthorized(const QString& action)
+{
+    // On the session bus every caller is the user that runs the program, on the
+    // system bus polkit decides, which lets active local sessions through
+    if (!calledFromDBus() || !m_engine.presets().powerProfiles.systemBus)
+        return true;
+
+    const PolkitSubject subject{ "system-bus-name", { { "name", message().service() } } };
+
+    QDBusMessage request = QDBusMessage::createMethodCall("org.freedesktop.PolicyKit1", "/org/freedesktop/PolicyKit1/Authority",
+        "org.freedesktop.PolicyKit1.Authority", "CheckAuthorization");
+    request << QVariant::fromValue(subject) << action << QVariant::fromValue(QMap<QString, QString>()) << 0u << QString();
+
+    // Without a prompt, a password dialog would stall every other caller
+    QDBusMessage reply = QDBusConnection(m_connectionName).call(request);
+
+    bool authorized = false;
+    if (reply.type() == QDBusMessage::ReplyMessage && !reply.arguments().isEmpty())
+    {
+        bool challenge = false;
+        QMap<QString, QString> details;
+
+        const QDBusArgument result = reply.arguments().first().value<QDBusArgument>();
+        result.beginStructure();
+        result >> authorized >> challenge >> details;
+        result.endStructure();
+    }
+    else
+    {
+        qDebug() << "Failed to check the polkit authorization:" << reply.errorMessage();
+    }
+
+    if (!authorized)
+    {
+        qDebug() << message().service() << "is not authorized for" << action;
+        sendErrorReply(QDBusError::AccessDenied, QString("Not authorized for %1").arg(action));
+    }
+
+    return authorized;
+}
+
+QString PowerProfilesService::profileForPreset(const QString& preset) const
+{
+    const QMap<QString, QString>& mapping = m_engine.presets().powerProfiles.profiles;
+
+    if (mapping.value(m_activeProfile) == preset)
+        return m_activeProfile;
+
+    for (const QString& name : g_profileNames)
+    {
+        if (mapping.value(name) == preset)
+            return name;
+    }
+
+    return m_activeProfile;
+}
+
+void PowerProfilesService::releaseHold(uint cookie)
+{
+    Hold hold = m_holds.take(cookie);
+
+    bool watched = false;
+    for (const Hold& other : std::as_const(m_holds))
+        watched = watched || other.sender == hold.sender;
+
+    if (!watched && !hold.sender.isEmpty())
+        m_serviceWatcher.removeWatchedService(hold.sender);
+
+    qDebug() << "Power profile hold" << cookie << "released.";
+    emit ProfileReleased(cookie);
+}
+
+void PowerProfilesService::updateHolds()
+{
+    notifyPropertyChanged("ActiveProfileHolds", QVariant::fromValue(activeProfileHolds()));
+
+    if (m_holds.isEmpty())
+    {
+        m_engine.releasePreset("powerProfiles");
+        return;
+    }
+
+    // Performance wins over power-saver when both are held
+    QString profile = "power-saver";
+    for (const Hold& hold : std::as_const(m_holds))
+    {
+        if (hold.profile == "performance")
+            profile = hold.profile;
+    }
+
+    const PowerProfilesSettings& settings = m_engine.presets().powerProfiles;
+    m_engine.requestPreset("powerProfiles", settings.profiles.value(profile), settings.holdPriority);
+}
+
+void PowerProfilesService::notifyPropertyChanged(const QString& name, const QVariant& value)
+{
+    if (!m_registered) return;
+
+    QDBusMessage signal = QDBusMessage::createSignal(g_objectPath, "org.freedesktop.DBus.Properties", "PropertiesChanged");
+    signal << g_serviceName << QVariantMap{ { name, value } } << QStringList();
+
+    QDBusConnection(m_connectionName).send(signal);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QDBusContext>
+#include <QDBusServiceWatcher>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+class PresetEngine;
+
+// Implements net.hadess.PowerProfiles, the interface of power-profiles-daemon,
+// so desktop quick settings can switch presets. Profiles are mapped to presets
+// in Presets.json, holds go through the policy arbiter of the engine.
+class PowerProfilesService : public QObject, protected QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "net.hadess.PowerProfiles")
+
+    Q_PROPERTY(QString ActiveProfile READ activeProfile WRITE setActiveProfile)
+    Q_PROPERTY(QString PerformanceInhibited READ performanceInhibited)
+    Q_PROPERTY(QString PerformanceDegraded READ performanceDegraded)
+    Q_PROPERTY(QList<QVariantMap> Profiles READ profiles)
+    Q_PROPERTY(QStringList Actions READ actions)
+    Q_PROPERTY(QList<QVariantMap> ActiveProfileHolds READ activeProfileHolds)
+    Q_PROPERTY(QString Version READ version)
+
+public:
+    explicit PowerProfilesService(PresetEngine& engine, QObject* parent = nullptr);
+    virtual ~PowerProfilesService();
+
+    bool start();
+
+    QString activeProfile() const;
+    void setActiveProfile(const QString& profile);
+
+    QString performanceInhibited() const;
+    QString performanceDegraded() const;
+    QList<QVariantMap> profiles() const;
+    QStringList actions() const;
+    QList<QVariantMap> activeProfileHolds() const;
+    QString version() const;
+
+public slots:
+    Q_SCRIPTABLE uint HoldProfile(const QString& profile, const QString& reason, const QString& applicationId);
+    Q_SCRIPTABLE void ReleaseProfile(uint cookie);
+
+signals:
+    Q_SCRIPTABLE void ProfileReleased(uint cookie);
+
+private slots:
+    void presetActivated(const QString& preset);
+    void serviceUnregistered(const QString& service);
+
+private:
+    struct Hold
+    {
+        QString profile;
+        QString reason;
+        QString applicationId;
+        QString sender;
+    };
+
+    bool isAuthorized(const QString& action);
+    QString profileForPreset(const QString& preset) const;
+    void releaseHold(uint cookie);
+    void updateHolds();
+    void notifyPropertyChanged(const QString& name, const QVariant& value);
+
+    PresetEngine& m_engine;
+
+    QDBusServiceWatcher m_serviceWatcher;
+    QMap<uint, Hold> m_holds;
+    uint m_nextCookie = 1;
+
+    QString m_connectionName;
+    QString m_activeProfile = "balanced";
+    bool m_registered = false;
+};
@@ -0,0 +1,276 @@
+#include "PowerSupplyMonitor.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSocketNotifier>
+
+#include <algorithm>
+#include <utility>
+
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <linux/netlink.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+static void readField(const QByteArray& field, const char* prefix, QByteArray& value)
+{
+    if (field.startsWith(prefix))
+        value = field.mid(qstrlen(prefix));
+}
+
+static QByteArray readSysfsFile(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    return file.readAll().trimmed();
+}
+
+PowerSupplyMonitor::PowerSupplyMonitor(QObject* parent)
+    : QObject(parent)
+{
+}
+
+PowerSupplyMonitor::~PowerSupplyMonitor()
+{
+    stop();
+}
+
+void PowerSupplyMonitor::setRules(const QList<PowerRule>& rules)
+{
+    m_rules = rules;
+    std::stable_sort(m_rules.begin(), m_rules.end(), [](const PowerRule& a, const PowerRule& b) { return a.priority > b.priority; });
+
+    m_activeRule = -2;
+}
+
+bool PowerSupplyMonitor::start(const QString& rootPath)
+{
+    stop();
+
+    m_rootPath = rootPath;
+    m_supplies.clear();
+    m_activeRule = -2;
+
+    QDir directory(rootPath);
+    for (const QString& name : directory.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+        readSupply(name);
+
+    updateState();
+
+#ifdef Q_OS_LINUX
+    m_socket = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (m_socket < 0)
+    {
+        qDebug() << "Failed to open uevent socket:" << strerror(errno);
+        return false;
+    }
+
+    // Group 1 carries the raw kernel uevents
+    sockaddr_nl address = {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = 1;
+
+    if (::bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+    {
+        qDebug() << "Failed to bind uevent socket:" << strerror(errno);
+        stop();
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &PowerSupplyMonitor::socketActivated);
+
+    return true;
+#else
+    qDebug() << "Power supply uevents are not supported on this platform.";
+    return false;
+#endif
+}
+
+void PowerSupplyMonitor::stop()
+{
+    delete m_notifier;
+    m_notifier = nullptr;
+
+#ifdef Q_OS_LINUX
+    if (m_socket >= 0)
+        ::close(m_socket);
+#endif
+
+    m_socket = -1;
+}
+
+void PowerSupplyMonitor::injectUevent(const QByteArray& message)
+{
+    bool powerSupply = false;
+    bool removed = false;
+
+    QByteArray name;
+    QByteArray type;
+    QByteArray online;
+    QByteArray capacity;
+
+    for (const QByteArray& field : message.split('\0'))
+    {
+        if (field == "SUBSYSTEM=power_supply")
+            powerSupply = true;
+
+        if (field == "ACTION=remove")
+            removed = true;
+
+        readField(field, "POWER_SUPPLY_NAME=", name);
+        readField(field, "POWER_SUPPLY_TYPE=", type);
+        readField(field, "POWER_SUPPLY_ONLINE=", online);
+        readField(field, "POWER_SUPPLY_CAPACITY=", capacity);
+    }
+
+    if (!powerSupply || name.isEmpty())
+        return;
+
+    QString supplyName = QString::fromLocal8Bit(name);
+
+    if (removed)
+    {
+        m_supplies.remove(supplyName);
+        updateState();
+        return;
+    }
+
+    if (!m_supplies.contains(supplyName))
+        readSupply(supplyName);
+
+    Supply& supply = m_supplies[supplyName];
+
+    if (!type.isEmpty())
+        supply.type = type;
+
+    if (!online.isEmpty())
+        supply.online = online.toInt() != 0;
+
+    if (!capacity.isEmpty())
+        supply.capacity = capacity.toInt();
+
+    for (auto it = m_supplies.begin(); it != m_supplies.end(); ++it)
+    {
+        if (it.value().type != "Battery" || (it.key() == supplyName && !capacity.isEmpty()))
+            continue;
+
+        QByteArray value = readSysfsFile(m_rootPath + "/" + it.key() + "/capacity");
+        if (!value.isEmpty())
+            it.value().capacity = value.toInt();
+    }
+
+    updateState();
+}
+
+bool PowerSupplyMonitor::isOnline() const
+{
+    return m_online;
+}
+
+int32_t PowerSupplyMonitor::capacity() const
+{
+    return m_capacity;
+}
+
+bool PowerSupplyMonitor::isForced() const
+{
+    return m_activeRule >= 0 && m_rules[m_activeRule].force;
+}
+
+void PowerSupplyMonitor::socketActivated()
+{
+#ifdef Q_OS_LINUX
+    char buffer[8192];
+
+    for (;;)
+    {
+        ssize_t size = ::recv(m_socket, buffer, sizeof(buffer), 0);
+        if (size <= 0)
+            break;
+
+        injectUevent(QByteArray::fromRawData(buffer, size));
+    }
+#endif
+}
+
+void PowerSupplyMonitor::readSupply(const QString& name)
+{
+    QString supplyPath = m_rootPath + "/" + name;
+
+    Supply supply;
+    supply.type = readSysfsFile(supplyPath + "/type");
+
+    QByteArray online = readSysfsFile(supplyPath + "/online");
+    supply.online = !online.isEmpty() && online.toInt() != 0;
+
+    QByteArray capacity = readSysfsFile(supplyPath + "/capacity");
+    supply.capacity = capacity.isEmpty() ? -1 : capacity.toInt();
+
+    m_supplies.insert(name, supply);
+}
+
+void PowerSupplyMonitor::updateState()
+{
+    bool hasMains = false;
+    bool online = false;
+    int32_t capacity = -1;
+
+    for (const Supply& supply : std::as_const(m_supplies))
+    {
+        if (supply.type == "Mains" || supply.type == "USB")
+        {
+            hasMains = true;
+            online = online || supply.online;
+        }
+        else if (supply.type == "Battery" && supply.capacity >= 0)
+        {
+            capacity = capacity < 0 ? supply.capacity : std::min(capacity, supply.capacity);
+        }
+    }
+
+    // Machines without any mains supply are always on AC
+    online = online || !hasMains;
+
+    if (online != m_online || capacity != m_capacity)
+    {
+        m_online = online;
+        m_capacity = capacity;
+
+        qDebug() << "Power supply changed, online:" << online << "capacity:" << capacity;
+        emit stateChanged(online, capacity);
+    }
+
+    int32_t rule = -1;
+    for (int32_t i = 0; i < m_rules.size(); ++i)
+    {
+        const PowerRule& powerRule = m_rules[i];
+
+        bool sourceMatch = powerRule.source == "any" || (powerRule.source == "ac") == online;
+        bool levelMatch = powerRule.below > 100 || (capacity >= 0 && capacity < powerRule.below);
+
+        if (sourceMatch && levelMatch)
+        {
+            rule = i;
+            break;
+        }
+    }
+
+    if (rule == m_activeRule)
+        return;
+
+    m_activeRule = rule;
+
+    if (rule < 0)
+        emit presetReleased();
+    else
+        emit presetRequested(m_rules[rule].preset, m_rules[rule].priority);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+QT_BEGIN_NAMESPACE
+class QSocketNotifier;
+QT_END_NAMESPACE
+
+struct PowerRule
+{
+    QString source;
+    int32_t below = 101;
+    QString preset;
+    int32_t priority = 0;
+    bool force = false;
+};
+
+// Tracks AC/battery state from power_supply uevents. The sysfs tree under
+// rootPath is read once at start and for supplies that appear later, after
+// that the state comes from the uevent payload itself. Many batteries send
+// no uevent per percent, so with every uevent the capacity of the others is
+// read again. A battery that drains without any uevent at all is seen late,
+// with the next status or AC change.
+class PowerSupplyMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PowerSupplyMonitor(QObject* parent = nullptr);
+    virtual ~PowerSupplyMonitor();
+
+    void setRules(const QList<PowerRule>& rules);
+
+    bool start(const QString& rootPath);
+    void stop();
+
+    void injectUevent(const QByteArray& message);
+
+    bool isOnline() const;
+    int32_t capacity() const;
+
+    // The matching rule keeps its preset across manual switches
+    bool isForced() const;
+
+signals:
+    void stateChanged(bool online, int32_t capacity);
+    void presetRequested(const QString& preset, int32_t priority);
+    void presetReleased();
+
+private slots:
+    void socketActivated();
+
+private:
+    struct Supply
+    {
+        QByteArray type;
+        bool online = false;
+        int32_t capacity = -1;
+    };
+
+    void readSupply(const QString& name);
+    void updateState();
+
+    QList<PowerRule> m_rules;
+    QHash<QString, Supply> m_supplies;
+    QString m_rootPath;
+
+    bool m_online = true;
+    int32_t m_capacity = -1;
+    int32_t m_activeRule = -2;
+
+    int m_socket = -1;
+    QSocketNotifier* m_notifier = nullptr;
+};
@@ -0,0 +1,902 @@
+#include "PresetEngine.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "Log.h"
+#include "Trace.h"
+
+static const char* const g_loadPhaseNames[] = { "idle", "memory", "compute" };
+
+PresetEngine::PresetEngine(const QString& filePath, QObject* parent)
+    : QObject(parent)
+    , m_powerPlan(createPowerPlan())
+    , m_filePath(filePath)
+{
+    connect(&m_updatePresetTimer, &QTimer::timeout, this, &PresetEngine::updatePreset);
+
+    connect(&m_pressureMonitor, &PressureMonitor::triggered, this, &PresetEngine::pressureTriggered);
+    connect(&m_pressureCalmTimer, &QTimer::timeout, this, &PresetEngine::pressureCalmTimeout);
+
+    connect(&m_perfTimer, &QTimer::timeout, this, &PresetEngine::perfTimeout);
+
+    connect(&m_processWatcher, &ProcessWatcher::presetRequested, this, &PresetEngine::processPresetRequested);
+    connect(&m_processWatcher, &ProcessWatcher::presetReleased, this, &PresetEngine::processPresetReleased);
+
+    connect(&m_powerSupplyMonitor, &PowerSupplyMonitor::presetRequested, this, &PresetEngine::powerSupplyPresetRequested);
+    connect(&m_powerSupplyMonitor, &PowerSupplyMonitor::presetReleased, this, &PresetEngine::powerSupplyPresetReleased);
+}
+
+PresetEngine::~PresetEngine()
+{
+}
+
+QStringList PresetEngine::argNames()
+{
+    return SmuBackend::argNames() << CpufreqControl::argNames() << "battery-saver";
+}
+
+void PresetEngine::setBackend(std::unique_ptr<SmuBackend> backend)
+{
+    m_backend = std::move(backend);
+}
+
+void PresetEngine::setPowerPlan(std::unique_ptr<PowerPlan> powerPlan)
+{
+    m_powerPlan = std::move(powerPlan);
+}
+
+Presets& PresetEngine::presets()
+{
+    return m_presets;
+}
+
+const QString& PresetEngine::filePath() const
+{
+    return m_filePath;
+}
+
+const QString& PresetEngine::activePreset() const
+{
+    return m_activePreset;
+}
+
+const Telemetry& PresetEngine::telemetry() const
+{
+    return m_telemetry;
+}
+
+const EngineStats& PresetEngine::stats() const
+{
+    return m_stats;
+}
+
+const EnergyAccountant& PresetEngine::energy() const
+{
+    return m_energy;
+}
+
+const ProcessEnergy& PresetEngine::processEnergy() const
+{
+    return m_processEnergy;
+}
+
+void PresetEngine::start()
+{
+    if (m_presets.trace)
+        Trace::setEnabled(true);
+
+    if (m_presets.energy.enabled)
+    {
+        // A tick may be late, only a gap well past it counts as a suspend
+        m_energy.load(m_presets.energy.filePath);
+        m_energy.setSaveInterval(m_presets.energy.saveInterval * 1000LL);
+        m_energy.setMaxGap(std::max<int64_t>(10LL * m_presets.updateRate, 10000));
+    }
+
+    m_processEnergy.setTopCount(m_presets.processEnergy.top);
+
+    // Socket power comes from the PM table, the watchdog skips its ticks without it
+    if ((m_presets.energy.enabled || m_presets.processEnergy.enabled) && (m_backend == nullptr || !m_backend->isReady()))
+        qDebug() << "Energy accounting is enabled, but the SMU backend is not available, nothing will be sampled.";
+
+    activatePreset(m_presets.lastPreset);
+
+    initPolicies();
+
+    m_updatePresetTimer.start(m_presets.updateRate);
+}
+
+void PresetEngine::reload()
+{
+    readPresets();
+    initCgroups();
+    updateActivePreset();
+}
+
+void PresetEngine::setUpdateRate(int32_t updateRate)
+{
+    m_presets.updateRate = updateRate;
+    writePresets();
+
+    m_updatePresetTimer.stop();
+    m_updatePresetTimer.start(m_presets.updateRate);
+}
+
+void PresetEngine::pressureTriggered()
+{
+    if (!m_policyRequests.contains("pressure"))
+        requestPreset("pressure", m_presets.pressure.preset, m_presets.pressure.priority);
+
+    m_pressureCalmTimer.start(m_presets.pressure.calmPeriod);
+}
+
+void PresetEngine::pressureCalmTimeout()
+{
+    // Hysteresis, stay escalated until the pressure drops below the calm level
+    if (m_pressureMonitor.readAverage() > m_presets.pressure.calmAverage)
+    {
+        m_pressureCalmTimer.start(m_presets.pressure.calmPeriod);
+        return;
+    }
+
+    releasePreset("pressure");
+}
+
+void PresetEngine::perfTimeout()
+{
+    PerfSample sample;
+    if (!m_perfCounters.read(sample))
+        return;
+
+    double elapsed = m_perfElapsed.restart() / 1000.0;
+    if (elapsed <= 0.0)
+        return;
+
+    const PerfPolicy& policy = m_presets.perfCounters;
+
+    double ipc = sample.instructionsPerCycle();
+    double mpki = sample.missesPerKiloInstruction();
+
+    LoadPhase phase = LoadPhase::Idle;
+    if (sample.cycles / elapsed >= policy.busyCycles)
+    {
+        if (mpki >= policy.memoryMpki && ipc <= policy.memoryIpc)
+            phase = LoadPhase::Memory;
+        else if (ipc >= policy.computeIpc)
+            phase = LoadPhase::Compute;
+    }
+
+    // Hysteresis, a phase has to last a few samples before the args follow it
+    if (phase != m_loadCandidate)
+    {
+        m_loadCandidate = phase;
+        m_loadCandidateCount = 0;
+    }
+
+    if (++m_loadCandidateCount < policy.samples || phase == m_loadPhase)
+        return;
+
+    m_loadPhase = phase;
+
+    REDMIOSD_LOG(Engine, LogEvent::LoadPhaseChanged, g_loadPhaseNames[static_cast<int32_t>(phase)], ipc, mpki);
+
+    switch (phase)
+    {
+        case LoadPhase::Memory:
+            setPhaseArgs(policy.memoryArgs);
+            break;
+        case LoadPhase::Compute:
+            setPhaseArgs(policy.computeArgs);
+            break;
+        default:
+            setPhaseArgs(QMap<QString, int32_t>());
+            break;
+    }
+}
+
+void PresetEngine::processPresetRequested(const QString& preset, int32_t priority)
+{
+    requestPreset("process", preset, priority);
+}
+
+void PresetEngine::processPresetReleased()
+{
+    releasePreset("process");
+}
+
+void PresetEngine::powerSupplyPresetRequested(const QString& preset, int32_t priority)
+{
+    requestPreset("powerSupply", preset, priority);
+}
+
+void PresetEngine::powerSupplyPresetReleased()
+{
+    releasePreset("powerSupply");
+}
+
+void PresetEngine::readPresets()
+{
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) 
+    {
+        qDebug() << "Failed to open file:" << file.errorString();
+        return;
+    }
+
+    QByteArray jsonData = file.readAll();
+    file.close();
+
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData);
+    if (jsonDoc.isNull() || !jsonDoc.isObject()) 
+    {
+        qDebug() << "Invalid JSON data.";
+        return;
+    }
+
+    QJsonObject rootObject = jsonDoc.object();
+
+    if (!rootObject.contains("defaultPreset"))
+    {
+        qDebug() << "Default preset not found in JSON.";
+        return;
+    }
+
+    if (!rootObject.contains("lastPreset"))
+    {
+        qDebug() << "Last preset not found in JSON.";
+        return;
+    }
+
+    if (!rootObject.contains("presets"))
+    {
+        qDebug() << "Presets array not found in JSON.";
+        return;
+    }
+
+    m_presets.defaultPreset = rootObject["defaultPreset"].toString();
+    m_presets.lastPreset = rootObject["lastPreset"].toString();
+    m_presets.updateRate = rootObject["updateRate"].toInt();
+    m_presets.startup = rootObject["startup"].toBool();
+    m_presets.liveEdit = rootObject["liveEdit"].toBool();
+    m_presets.showTray = rootObject["showTray"].toBool();
+    m_presets.showOverlay = rootObject["showOverlay"].toBool();
+    m_presets.trayValue = rootObject["trayValue"].toString("none");
+    m_presets.trayInterval = rootObject["trayInterval"].toInt(1000);
+    m_presets.trace = rootObject["trace"].toBool(false);
+
+    QJsonObject smuObject = rootObject["smu"].toObject();
+    m_presets.smu.backend = smuObject["backend"].toString("ryzenadj");
+    m_presets.smu.rootPath = smuObject["path"].toString("/sys/kernel/ryzen_smu_drv");
+    m_presets.smu.tctlOffset = smuObject["tctlOffset"].toInt(-1);
+    m_presets.smu.socketPowerOffset = smuObject["socketPowerOffset"].toInt(-1);
+
+    QJsonObject cpufreqObject = rootObject["cpufreq"].toObject();
+    m_presets.cpufreq.rootPath = cpufreqObject["path"].toString("/sys/devices/system/cpu/cpufreq");
+
+    QJsonObject cgroupObject = rootObject["cgroup"].toObject();
+    m_presets.cgroup.rootPath = cgroupObject["path"].toString("/sys/fs/cgroup");
+
+    QJsonObject pressureObject = rootObject["pressure"].toObject();
+    m_presets.pressure.enabled = pressureObject["enabled"].toBool(false);
+    m_presets.pressure.filePath = pressureObject["path"].toString("/proc/pressure/cpu");
+    m_presets.pressure.preset = pressureObject["preset"].toString("turbo");
+    m_presets.pressure.priority = pressureObject["priority"].toInt(10);
+    m_presets.pressure.threshold = pressureObject["threshold"].toInt(150000);
+    m_presets.pressure.window = pressureObject["window"].toInt(2000000);
+    m_presets.pressure.calmPeriod = pressureObject["calmPeriod"].toInt(10000);
+    m_presets.pressure.calmAverage = pressureObject["calmAverage"].toDouble(10.0);
+
+    QJsonObject perfObject = rootObject["perfCounters"].toObject();
+    m_presets.perfCounters.enabled = perfObject["enabled"].toBool(false);
+    m_presets.perfCounters.interval = perfObject["interval"].toInt(1000);
+    m_presets.perfCounters.samples = perfObject["samples"].toInt(3);
+    m_presets.perfCounters.memoryMpki = perfObject["memoryMpki"].toDouble(10.0);
+    m_presets.perfCounters.memoryIpc = perfObject["memoryIpc"].toDouble(0.8);
+    m_presets.perfCounters.computeIpc = perfObject["computeIpc"].toDouble(1.5);
+    m_presets.perfCounters.busyCycles = perfObject["busyCycles"].toDouble(1.0e9);
+    m_presets.perfCounters.memoryArgs.clear();
+    m_presets.perfCounters.computeArgs.clear();
+
+    QJsonObject memoryArgsObject = perfObject["memoryArgs"].toObject();
+    for (auto it = memoryArgsObject.constBegin(); it != memoryArgsObject.constEnd(); ++it)
+        m_presets.perfCounters.memoryArgs.insert(it.key(), it.value().toInt());
+
+    QJsonObject computeArgsObject = perfObject["computeArgs"].toObject();
+    for (auto it = computeArgsObject.constBegin(); it != computeArgsObject.constEnd(); ++it)
+        m_presets.perfCounters.computeArgs.insert(it.key(), it.value().toInt());
+
+    QJsonObject processObject = rootObject["processWatch"].toObject();
+    m_presets.processWatch.enabled = processObject["enabled"].toBool(false);
+    m_presets.processWatch.scanInterval = processObject["scanInterval"].toInt(2000);
+    m_presets.processWatch.rules.clear();
+
+    QJsonArray rulesArray = processObject["rules"].toArray();
+    for (const QJsonValue& ruleValue : rulesArray)
+    {
+        QJsonObject ruleObject = ruleValue.toObject();
+
+        ProcessRule rule;
+        rule.preset = ruleObject["preset"].toString();
+        rule.priority = ruleObject["priority"].toInt();
+
+        for (const QJsonValue& name : ruleObject["names"].toArray())
+            rule.names.append(name.toString());
+
+        for (const QJsonValue& cgroup : ruleObject["cgroups"].toArray())
+            rule.cgroups.append(cgroup.toString());
+
+        m_presets.processWatch.rules.append(rule);
+    }
+
+    QJsonObject powerSupplyObject = rootObject["powerSupply"].toObject();
+    m_presets.powerSupply.enabled = powerSupplyObject["enabled"].toBool(false);
+    m_presets.powerSupply.rootPath = powerSupplyObject["path"].toString("/sys/class/power_supply");
+    m_presets.powerSupply.rules.clear();
+
+    QJsonArray powerRulesArray = powerSupplyObject["rules"].toArray();
+    for (const QJsonValue& ruleValue : powerRulesArray)
+    {
+        QJsonObject ruleObject = ruleValue.toObject();
+
+        PowerRule rule;
+        rule.source = ruleObject["source"].toString("any");
+
+        // Anything else would count as battery
+        if (rule.source != "ac" && rule.source != "battery" && rule.source != "any")
+        {
+            qDebug() << "Unknown power supply source" << rule.source << "in the rule of preset" << ruleObject["preset"].toString();
+            continue;
+        }
+
+        rule.below = ruleObject["below"].toInt(101);
+        rule.preset = ruleObject["preset"].toString();
+        rule.priority = ruleObject["priority"].toInt();
+        rule.force = ruleObject["force"].toBool(false);
+
+        m_presets.powerSupply.rules.append(rule);
+    }
+
+    QJsonObject metricsObject = rootObject["metrics"].toObject();
+    m_presets.metrics.enabled = metricsObject["enabled"].toBool(false);
+    m_presets.metrics.port = metricsObject["port"].toInt(9777);
+
+    QJsonObject energyObject = rootObject["energy"].toObject();
+    m_presets.energy.enabled = energyObject["enabled"].toBool(false);
+    m_presets.energy.filePath = energyObject["path"].toString("Energy.bin");
+    m_presets.energy.saveInterval = energyObject["saveInterval"].toInt(600);
+
+    QJsonObject processEnergyObject = rootObject["processEnergy"].toObject();
+    m_presets.processEnergy.enabled = processEnergyObject["enabled"].toBool(false);
+    m_presets.processEnergy.top = processEnergyObject["top"].toInt(5);
+
+    QJsonObject powerProfilesObject = rootObject["powerProfiles"].toObject();
+    m_presets.powerProfiles.enabled = powerProfilesObject["enabled"].toBool(false);
+    m_presets.powerProfiles.systemBus = powerProfilesObject["bus"].toString("system") != "session";
+    m_presets.powerProfiles.holdPriority = powerProfilesObject["holdPriority"].toInt(50);
+    m_presets.powerProfiles.profiles.clear();
+
+    QJsonObject profilesObject = powerProfilesObject["profiles"].toObject();
+    for (auto it = profilesObject.constBegin(); it != profilesObject.constEnd(); ++it)
+        m_presets.powerProfiles.profiles.insert(it.key(), it.value().toString());
+
+    QJsonArray presetsArray = rootObject["presets"].toArray();
+    for (const QJsonValue& presetValue : presetsArray) 
+    {
+        if (!presetValue.isObject()) 
+        {
+            qDebug() << "Invalid preset format.";
+            continue;
+        }
+
+        QJsonObject presetObject = presetValue.toObject();
+        QString presetName = presetObject["name"].toString();
+        QString shortcut = presetObject["shortcut"].toString();
+        QString holdShortcut = presetObject["holdShortcut"].toString();
+        
+        QJsonObject argsObject = presetObject["args"].toObject();
+        
+        QMap<QString, int32_t> argsMap;
+
+        for (auto it = argsObject.constBegin(); it != argsObject.constEnd(); ++it)
+        {
+            if (it.key() == "epp" && it.value().isString())
+            {
+                int32_t epp = CpufreqControl::parseEpp(it.value().toString());
+                if (epp < 0)
+                {
+                    qDebug() << "Unknown epp" << it.value().toString() << "in preset" << presetName;
+                    continue;
+                }
+
+                argsMap.insert(it.key(), epp);
+            }
+            else
+                argsMap.insert(it.key(), it.value().toInt());
+        }
+        
+        QMap<QString, CgroupLimits> cgroupsMap;
+
+        QJsonObject cgroupsObject = presetObject["cgroups"].toObject();
+        for (auto it = cgroupsObject.constBegin(); it != cgroupsObject.constEnd(); ++it)
+        {
+            QJsonObject limitsObject = it.value().toObject();
+            cgroupsMap.insert(it.key(), { limitsObject["cpus"].toString(), limitsObject["max"].toString() });
+        }
+
+        m_presets.argsMap.insert(presetName, argsMap);
+        m_presets.cgroupsMap.insert(presetName, cgroupsMap);
+        m_presets.shorcutsMap.insert(presetName, shortcut);
+        m_presets.holdShortcutsMap.insert(presetName, holdShortcut);
+    }
+
+    REDMIOSD_LOG(Config, LogEvent::PresetsRead, m_presets.argsMap.size());
+}
+
+void PresetEngine::writePresets()
+{
+    REDMIOSD_TRACE("writePresets");
+
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Text))
+    {
+        qDebug() << "Failed to open file:" << file.errorString();
+        return;
+    }
+
+    QByteArray jsonData = file.readAll();
+    file.close();
+
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData);
+    if (jsonDoc.isNull() || !jsonDoc.isObject())
+    {
+        qDebug() << "Invalid JSON data.";
+        return;
+    }
+
+    QJsonObject rootObject = jsonDoc.object();
+
+    QJsonArray presetsArray = rootObject["presets"].toArray();
+    for (QJsonValueRef presetValue : presetsArray)
+    {
+        if (!presetValue.isObject())
+        {
+            qDebug() << "Invalid preset format.";
+            continue;
+        }
+
+        QJsonObject presetObject = presetValue.toObject();
+        QString presetName = presetObject["name"].toString();
+        
+        presetObject["shortcut"] = m_presets.shorcutsMap[presetName];
+        presetValue = presetObject;
+    }
+
+    rootObject["presets"] = presetsArray;
+    rootObject["defaultPreset"] = m_presets.defaultPreset;
+    rootObject["lastPreset"] = m_presets.lastPreset;
+    rootObject["updateRate"] = m_presets.updateRate;
+    rootObject["startup"] = m_presets.startup;
+    rootObject["liveEdit"] = m_presets.liveEdit;
+    rootObject["showTray"] = m_presets.showTray;
+    rootObject["showOverlay"] = m_presets.showOverlay;
+
+    jsonDoc.setObject(rootObject);
+
+    file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate);
+    if (!file.isOpen())
+    {
+        qDebug() << "Failed to open file for writing:" << file.errorString();
+        return;
+    }
+
+    file.write(jsonDoc.toJson());
+    file.close();
+
+    REDMIOSD_LOG(Config, LogEvent::PresetsWritten);
+}
+
+void PresetEngine::initPreset()
+{
+    if (m_presets.defaultPreset != m_presets.lastPreset && m_presets.defaultPreset != "lastPreset")
+    {
+        m_presets.lastPreset = m_presets.defaultPreset;
+        writePresets();
+    }
+
+    initBackend();
+}
+
+bool PresetEngine::initBackend()
+{
+    if (!m_cpufreq.isOpen())
+        m_cpufreq.open(m_presets.cpufreq.rootPath);
+
+    initCgroups();
+
+    if (m_backend == nullptr)
+        m_backend = createSmuBackend(m_presets.smu);
+
+    return m_backend != nullptr && m_backend->init();
+}
+
+void PresetEngine::initCgroups()
+{
+    QStringList cgroups;
+    for (const QMap<QString, CgroupLimits>& cgroupsMap : std::as_const(m_presets.cgroupsMap))
+        cgroups << cgroupsMap.keys();
+
+    cgroups.removeDuplicates();
+
+    // Also with none left, a reload gives the dropped ones back
+    m_cgroups.open(m_presets.cgroup.rootPath, cgroups);
+}
+
+void PresetEngine::initPolicies()
+{
+    m_pressureCalmTimer.setSingleShot(true);
+
+    if (m_presets.pressure.enabled)
+        m_pressureMonitor.start(m_presets.pressure.filePath, m_presets.pressure.threshold, m_presets.pressure.window);
+
+    if (m_presets.processWatch.enabled)
+    {
+        m_processWatcher.setRules(m_presets.processWatch.rules);
+        m_processWatcher.start(m_presets.processWatch.scanInterval);
+    }
+
+    if (m_presets.powerSupply.enabled)
+    {
+        m_powerSupplyMonitor.setRules(m_presets.powerSupply.rules);
+        m_powerSupplyMonitor.start(m_presets.powerSupply.rootPath);
+    }
+
+    // The counters are opened once, every tick is a read of each group
+    if (m_presets.perfCounters.enabled && m_perfCounters.open())
+    {
+        PerfSample sample;
+        m_perfCounters.read(sample);
+        m_perfElapsed.start();
+
+        m_perfTimer.start(m_presets.perfCounters.interval);
+    }
+}
+
+void PresetEngine::switchPreset(const QString& preset)
+{
+    REDMIOSD_TRACE("switchPreset", preset);
+
+    m_presets.lastPreset = preset;
+
+    // A manual switch wins over everything the policies requested so far,
+    // except a forced power supply rule, e.g. silence on a low battery
+    auto powerRequest = m_policyRequests.constFind("powerSupply");
+    bool forced = powerRequest != m_policyRequests.constEnd() && m_powerSupplyMonitor.isForced();
+    PolicyRequest request = forced ? powerRequest.value() : PolicyRequest();
+
+    m_policyRequests.clear();
+    m_pressureCalmTimer.stop();
+
+    if (forced)
+    {
+        qDebug() << "Power supply rule forces" << request.preset << "," << preset << "takes over once it is released.";
+
+        m_policyRequests.insert("powerSupply", request);
+        updateActivePreset();
+    }
+    else
+    {
+        activatePreset(preset);
+    }
+
+    // Saved after the apply, so the file write is not part of the switch latency
+    writePresets();
+}
+
+void PresetEngine::activatePreset(const QString& preset, bool fast)
+{
+    REDMIOSD_TRACE("activatePreset", preset);
+
+    QMap<QString, int32_t> currentArgs;
+    if (fast)
+    {
+        currentArgs = m_presets.argsMap.value(m_activePreset);
+        currentArgs.insert(m_overrides);
+        currentArgs.insert(m_phaseArgs);
+    }
+
+    // The args of the load phase stay on top of every preset that sets them,
+    // the others get back the value the phase replaced
+    QMap<QString, int32_t> args = m_presets.argsMap[preset];
+    for (auto it = m_phaseArgs.begin(); it != m_phaseArgs.end();)
+    {
+        auto presetArg = args.constFind(it.key());
+        if (presetArg == args.constEnd())
+        {
+            args.insert(it.key(), m_phaseRestore.take(it.key()));
+            it = m_phaseArgs.erase(it);
+            continue;
+        }
+
+        m_phaseRestore.insert(it.key(), presetArg.value());
+        args.insert(it.key(), it.value());
+        ++it;
+    }
+
+    QMap<QString, int32_t> changedArgs;
+    if (fast)
+    {
+        // Only the args that differ from what is applied now reach the SMU
+        for (auto it = args.constBegin(); it != args.constEnd(); ++it)
+        {
+            auto current = currentArgs.constFind(it.key());
+            if (current == currentArgs.constEnd() || current.value() != it.value())
+                changedArgs.insert(it.key(), it.value());
+        }
+    }
+
+    m_activePreset = preset;
+    m_overrides.clear();
+
+    emit presetApplying(preset);
+
+    bool applied = fast ? applyPreset(changedArgs, false) : applyPreset(args);
+
+    if (m_cgroups.isOpen())
+    {
+        REDMIOSD_TRACE("cgroups");
+        applied = m_cgroups.apply(m_presets.cgroupsMap.value(preset)) && applied;
+    }
+
+    REDMIOSD_LOG(Engine, LogEvent::PresetActivated, preset);
+
+    emit presetActivated(preset);
+
+    if (!applied)
+        emit presetFailed(preset);
+}
+
+void PresetEngine::requestPreset(const QString& source, const QString& preset, int32_t priority)
+{
+    if (!m_presets.argsMap.contains(preset))
+    {
+        qDebug() << "Unknown preset requested by" << source << ":" << preset;
+        return;
+    }
+
+    m_policyRequests.insert(source, { preset, priority });
+    updateActivePreset();
+}
+
+void PresetEngine::releasePreset(const QString& source)
+{
+    if (m_policyRequests.remove(source))
+        updateActivePreset();
+}
+
+void PresetEngine::holdPreset(const QString& preset)
+{
+    if (!m_presets.argsMap.contains(preset))
+    {
+        qDebug() << "Unknown preset to hold:" << preset;
+        return;
+    }
+
+    REDMIOSD_TRACE("holdPreset", preset);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Wins over every policy, but only while the key is down
+    m_policyRequests.insert("hold", { preset, std::numeric_limits<int32_t>::max() });
+
+    if (preset != m_activePreset)
+        activatePreset(preset, true);
+
+    REDMIOSD_LOG(Engine, LogEvent::HoldApplied, preset, timer.nsecsElapsed() / 1000);
+}
+
+void PresetEngine::releaseHold()
+{
+    if (!m_policyRequests.remove("hold"))
+        return;
+
+    REDMIOSD_TRACE("releaseHold");
+
+    QElapsedTimer timer;
+    timer.start();
+
+    updateActivePreset(true);
+
+    REDMIOSD_LOG(Engine, LogEvent::HoldReleased, m_activePreset, timer.nsecsElapsed() / 1000);
+}
+
+void PresetEngine::overridePreset(const QMap<QString, int32_t>& args)
+{
+    // Lasts until the next preset switch, the watchdog keeps it applied
+    m_overrides.insert(args);
+
+    applyPreset(args);
+}
+
+void PresetEngine::updateActivePreset(bool fast)
+{
+    QString preset = m_presets.lastPreset;
+    int32_t priority = std::numeric_limits<int32_t>::min();
+
+    for (auto it = m_policyRequests.constBegin(); it != m_policyRequests.constEnd(); ++it)
+    {
+        if (it.value().priority > priority)
+        {
+            preset = it.value().preset;
+            priority = it.value().priority;
+        }
+    }
+
+    if (preset != m_activePreset)
+        activatePreset(preset, fast);
+}
+
+bool PresetEngine::applyPreset(const QMap<QString, int32_t>& args, bool powerPlan)
+{
+    // cpufreq works on its own, e.g. on Linux without an SMU backend
+    bool smu = m_backend != nullptr && m_backend->isReady();
+    if (!smu && !m_cpufreq.isOpen()) return false;
+
+    REDMIOSD_TRACE("applyPreset");
+
+    bool applied = true;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (auto it = args.begin(); it != args.end(); ++it)
+    {
+        if (smu && m_backend->hasArg(it.key()))
+        {
+            REDMIOSD_TRACE("smu.set", it.key());
+
+            int32_t result = m_backend->applyArg(it.key(), it.value());
+            if (result < 0)
+            {
+                m_stats.recordError(result);
+                applied = false;
+
+                REDMIOSD_LOG(Apply, LogEvent::ApplyFailed, it.key(), it.value(), result);
+            }
+            else
+            {
+                REDMIOSD_LOG(Apply, LogEvent::ApplyArg, it.key(), it.value());
+            }
+        }
+    }
+
+    if (m_cpufreq.isOpen())
+    {
+        REDMIOSD_TRACE("cpufreq");
+
+        // A full apply doesn't trust the cache, so values other tools wrote
+        // in the meantime are put back as well
+        if (powerPlan)
+            m_cpufreq.refresh();
+
+        if (m_cpufreq.apply(args) > 0)
+            applied = false;
+    }
+
+    if (powerPlan && m_powerPlan != nullptr && args.contains("battery-saver"))
+    {
+        REDMIOSD_TRACE("powerPlan");
+        m_powerPlan->setBatterySaver(args["battery-saver"]);
+    }
+
+    if (smu)
+    {
+        REDMIOSD_TRACE("smu.refresh_table");
+        m_backend->refreshTable();
+        m_backend->readTelemetry(m_telemetry);
+    }
+
+    m_fastCache = static_cast<int32_t>(m_telemetry.fastLimit);
+    m_slowCache = static_cast<int32_t>(m_telemetry.slowLimit);
+
+    int64_t elapsed = timer.nsecsElapsed();
+    m_stats.recordApply(elapsed / 1000000.0);
+
+    REDMIOSD_LOG(Apply, LogEvent::ApplyFinished, elapsed / 1000);
+
+    return applied;
+}
+
+void PresetEngine::updatePreset()
+{
+    if (m_backend == nullptr || !m_backend->isReady()) return;
+
+    ++m_stats.watchdogWakeups;
+
+    REDMIOSD_TRACE("watchdog");
+
+    m_backend->refreshTable();
+
+    updateTelemetry();
+
+    if (m_fastCache != static_cast<int32_t>(m_telemetry.fastLimit) || m_slowCache != static_cast<int32_t>(m_telemetry.slowLimit))
+    {
+        ++m_stats.driftEvents;
+
+        REDMIOSD_LOG(Engine, LogEvent::LimitsDrifted, m_activePreset, m_telemetry.fastLimit, m_telemetry.slowLimit);
+
+        QMap<QString, int32_t> args = m_presets.argsMap[m_activePreset];
+        args.insert(m_overrides);
+        args.insert(m_phaseArgs);
+
+        applyPreset(args);
+    }
+}
+
+void PresetEngine::setPhaseArgs(const QMap<QString, int32_t>& args)
+{
+    QMap<QString, int32_t> presetArgs = m_presets.argsMap.value(m_activePreset);
+    presetArgs.insert(m_overrides);
+
+    QMap<QString, int32_t> phaseArgs;
+    for (auto it = args.constBegin(); it != args.constEnd(); ++it)
+    {
+        // Without a value of the preset there would be nothing to go back to
+        if (!presetArgs.contains(it.key()))
+        {
+            qDebug() << "Load phase arg" << it.key() << "ignored, preset" << m_activePreset << "does not set it.";
+            continue;
+        }
+
+        phaseArgs.insert(it.key(), it.value());
+    }
+
+    QMap<QString, int32_t> changedArgs;
+
+    // Args of the previous phase get back the value they replaced
+    for (auto it = m_phaseArgs.constBegin(); it != m_phaseArgs.constEnd(); ++it)
+    {
+        if (!phaseArgs.contains(it.key()))
+            changedArgs.insert(it.key(), m_phaseRestore.take(it.key()));
+    }
+
+    for (auto it = phaseArgs.constBegin(); it != phaseArgs.constEnd(); ++it)
+    {
+        if (!m_phaseRestore.contains(it.key()))
+            m_phaseRestore.insert(it.key(), presetArgs.value(it.key()));
+
+        auto current = m_phaseArgs.constFind(it.key());
+        if (current == m_phaseArgs.constEnd() || current.value() != it.value())
+            changedArgs.insert(it.key(), it.value());
+    }
+
+    m_phaseArgs = phaseArgs;
+
+    if (!changedArgs.isEmpty())
+        applyPreset(changedArgs, false);
+}
+
+void PresetEngine::updateTelemetry()
+{
+    m_telemetry.timestamp = QDateTime::currentMSecsSinceEpoch();
+    m_backend->readTelemetry(m_telemetry);
+
+    if (m_presets.energy.enabled)
+        m_energy.addSample(m_telemetry.timestamp, m_telemetry.socketPower, m_activePreset);
+
+    if (m_presets.processEnergy.enabled)
+        m_processEnergy.update(m_telemetry.timestamp, m_telemetry.socketPower);
+
+    emit telemetryUpdated();
+}
\ No newline at end of file
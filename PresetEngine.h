@@ -0,0 +1,236 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+#include <memory>
+
+#include "CgroupControl.h"
+#include "CpufreqControl.h"
+#include "EnergyAccountant.h"
+#include "PerfCounters.h"
+#include "Platform.h"
+#include "PowerSupplyMonitor.h"
+#include "PressureMonitor.h"
+#include "ProcessEnergy.h"
+#include "ProcessWatcher.h"
+#include "SmuBackend.h"
+#include "Telemetry.h"
+
+struct PressurePolicy
+{
+    bool enabled = false;
+    QString filePath = "/proc/pressure/cpu";
+    QString preset = "turbo";
+    int32_t priority = 10;
+    int32_t threshold = 150000;
+    int32_t window = 2000000;
+    int32_t calmPeriod = 10000;
+    double calmAverage = 10.0;
+};
+
+struct PerfPolicy
+{
+    bool enabled = false;
+    int32_t interval = 1000;
+    int32_t samples = 3;
+    double memoryMpki = 10.0;
+    double memoryIpc = 0.8;
+    double computeIpc = 1.5;
+    double busyCycles = 1.0e9;
+    QMap<QString, int32_t> memoryArgs;
+    QMap<QString, int32_t> computeArgs;
+};
+
+struct ProcessPolicy
+{
+    bool enabled = false;
+    int32_t scanInterval = 2000;
+    QList<ProcessRule> rules;
+};
+
+struct PowerSupplyPolicy
+{
+    bool enabled = false;
+    QString rootPath = "/sys/class/power_supply";
+    QList<PowerRule> rules;
+};
+
+struct MetricsSettings
+{
+    bool enabled = false;
+    int32_t port = 9777;
+};
+
+struct EnergySettings
+{
+    bool enabled = false;
+    QString filePath = "Energy.bin";
+    int32_t saveInterval = 600;
+};
+
+struct ProcessEnergySettings
+{
+    bool enabled = false;
+    int32_t top = 5;
+};
+
+struct PowerProfilesSettings
+{
+    bool enabled = false;
+    bool systemBus = true;
+    int32_t holdPriority = 50;
+    QMap<QString, QString> profiles;
+};
+
+struct PolicyRequest
+{
+    QString preset;
+    int32_t priority;
+};
+
+struct Presets
+{
+    QMap<QString, QMap<QString, int32_t>> argsMap;
+    QMap<QString, QString> shorcutsMap;
+    QMap<QString, QString> holdShortcutsMap;
+    QMap<QString, QMap<QString, CgroupLimits>> cgroupsMap;
+    QString defaultPreset;
+    QString lastPreset;
+    int32_t updateRate;
+    bool startup;
+    bool liveEdit;
+    bool showTray;
+    bool showOverlay;
+    QString trayValue;
+    int32_t trayInterval;
+    bool trace;
+    SmuSettings smu;
+    CpufreqSettings cpufreq;
+    CgroupSettings cgroup;
+    PressurePolicy pressure;
+    PerfPolicy perfCounters;
+    ProcessPolicy processWatch;
+    PowerSupplyPolicy powerSupply;
+    MetricsSettings metrics;
+    EnergySettings energy;
+    ProcessEnergySettings processEnergy;
+    PowerProfilesSettings powerProfiles;
+};
+
+// Owns the preset file, the SMU backend, the watchdog and the automatic
+// policies. Depends on QtCore only, so the GUI and the daemon share it.
+class PresetEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PresetEngine(const QString& filePath, QObject* parent = nullptr);
+    virtual ~PresetEngine();
+
+    static QStringList argNames();
+
+    // Replace the backend picked by the "smu" settings, e.g. with a simulated one
+    void setBackend(std::unique_ptr<SmuBackend> backend);
+    void setPowerPlan(std::unique_ptr<PowerPlan> powerPlan);
+
+    Presets& presets();
+    const QString& filePath() const;
+    const QString& activePreset() const;
+    const Telemetry& telemetry() const;
+    const EngineStats& stats() const;
+    const EnergyAccountant& energy() const;
+    const ProcessEnergy& processEnergy() const;
+
+    void readPresets();
+    void writePresets();
+
+    void initPreset();
+    bool initBackend();
+    void start();
+    void reload();
+
+    void switchPreset(const QString& preset);
+    void requestPreset(const QString& source, const QString& preset, int32_t priority);
+    void releasePreset(const QString& source);
+    void holdPreset(const QString& preset);
+    void releaseHold();
+    void overridePreset(const QMap<QString, int32_t>& args);
+
+    void setUpdateRate(int32_t updateRate);
+
+signals:
+    void presetApplying(const QString& preset);
+    void presetActivated(const QString& preset);
+    void presetFailed(const QString& preset);
+    void telemetryUpdated();
+
+private slots:
+    void updatePreset();
+
+    void pressureTriggered();
+    void pressureCalmTimeout();
+
+    void perfTimeout();
+
+    void processPresetRequested(const QString& preset, int32_t priority);
+    void processPresetReleased();
+
+    void powerSupplyPresetRequested(const QString& preset, int32_t priority);
+    void powerSupplyPresetReleased();
+
+private:
+    enum class LoadPhase
+    {
+        Idle,
+        Memory,
+        Compute
+    };
+
+    void initPolicies();
+    void initCgroups();
+    void activatePreset(const QString& preset, bool fast = false);
+    bool applyPreset(const QMap<QString, int32_t>& args, bool powerPlan = true);
+    void updateActivePreset(bool fast = false);
+    void updateTelemetry();
+    void setPhaseArgs(const QMap<QString, int32_t>& args);
+
+    std::unique_ptr<SmuBackend> m_backend;
+    std::unique_ptr<PowerPlan> m_powerPlan;
+    CpufreqControl m_cpufreq;
+    CgroupControl m_cgroups;
+
+    int32_t m_fastCache = 0;
+    int32_t m_slowCache = 0;
+
+    QTimer m_updatePresetTimer;
+    QTimer m_pressureCalmTimer;
+    QTimer m_perfTimer;
+
+    PressureMonitor m_pressureMonitor;
+    PerfCounters m_perfCounters;
+    ProcessWatcher m_processWatcher;
+    PowerSupplyMonitor m_powerSupplyMonitor;
+
+    QMap<QString, PolicyRequest> m_policyRequests;
+    QMap<QString, int32_t> m_overrides;
+    QMap<QString, int32_t> m_phaseArgs;
+    QMap<QString, int32_t> m_phaseRestore;
+    QElapsedTimer m_perfElapsed;
+    LoadPhase m_loadPhase = LoadPhase::Idle;
+    LoadPhase m_loadCandidate = LoadPhase::Idle;
+    int32_t m_loadCandidateCount = 0;
+    QString m_activePreset;
+
+    Telemetry m_telemetry;
+    EngineStats m_stats;
+    EnergyAccountant m_energy;
+    ProcessEnergy m_processEnergy;
+
+    Presets m_presets;
+    QString m_filePath;
+};
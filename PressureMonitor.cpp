@@ -0,0 +1,104 @@
+#include "PressureMonitor.h"
+
+#include <QDebug>
+#include <QSocketNotifier>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#endif
+
+PressureMonitor::PressureMonitor(QObject* parent)
+    : QObject(parent)
+{
+}
+
+PressureMonitor::~PressureMonitor()
+{
+    stop();
+}
+
+bool PressureMonitor::start(const QString& filePath, int32_t threshold, int32_t window)
+{
+    stop();
+
+#ifdef Q_OS_LINUX
+    m_fd = ::open(filePath.toLocal8Bit().constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0)
+    {
+        qDebug() << "Failed to open pressure file:" << filePath << strerror(errno);
+        return false;
+    }
+
+    // The trigger lives as long as the descriptor stays open
+    QByteArray trigger = QString("some %1 %2").arg(threshold).arg(window).toLatin1();
+    if (::write(m_fd, trigger.constData(), trigger.size() + 1) < 0)
+    {
+        qDebug() << "Failed to register pressure trigger:" << trigger << strerror(errno);
+        stop();
+        return false;
+    }
+
+    // PSI signals a crossed threshold with POLLPRI
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Exception, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &PressureMonitor::notifierActivated);
+
+    qDebug() << "Pressure trigger registered:" << filePath << trigger;
+    return true;
+#else
+    Q_UNUSED(filePath);
+    Q_UNUSED(threshold);
+    Q_UNUSED(window);
+
+    qDebug() << "Pressure stall information is not supported on this platform.";
+    return false;
+#endif
+}
+
+void PressureMonitor::stop()
+{
+    delete m_notifier;
+    m_notifier = nullptr;
+
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0)
+        ::close(m_fd);
+#endif
+
+    m_fd = -1;
+}
+
+bool PressureMonitor::isActive() const
+{
+    return m_fd >= 0;
+}
+
+double PressureMonitor::readAverage() const
+{
+#ifdef Q_OS_LINUX
+    if (m_fd < 0) return 0.0;
+
+    char buffer[256];
+    ssize_t size = ::pread(m_fd, buffer, sizeof(buffer) - 1, 0);
+    if (size <= 0) return 0.0;
+
+    buffer[size] = '\0';
+
+    double avg10 = 0.0;
+    if (std::sscanf(buffer, "some avg10=%lf", &avg10) != 1)
+        return 0.0;
+
+    return avg10;
+#else
+    return 0.0;
+#endif
+}
+
+void PressureMonitor::notifierActivated()
+{
+    emit triggered();
+}
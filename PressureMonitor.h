@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+QT_BEGIN_NAMESPACE
+class QSocketNotifier;
+QT_END_NAMESPACE
+
+// Subscribes to a kernel PSI trigger (Linux >= 5.2). The kernel wakes us only
+// when the stall time inside the window crosses the threshold, so there is no
+// polling while the machine is idle.
+class PressureMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PressureMonitor(QObject* parent = nullptr);
+    virtual ~PressureMonitor();
+
+    bool start(const QString& filePath, int32_t threshold, int32_t window);
+    void stop();
+
+    bool isActive() const;
+    double readAverage() const;
+
+signals:
+    void triggered();
+
+private slots:
+    void notifierActivated();
+
+private:
+    int m_fd = -1;
+    QSocketNotifier* m_notifier = nullptr;
+};
@@ -0,0 +1,283 @@
+#include "ProcessEnergy.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+// /proc is listed on every n-th update only, known pids are read every time
+constexpr int32_t g_scanInterval = 5;
+
+// Past this many descriptors a stat file is opened for each read instead
+constexpr int32_t g_maxOpenFiles = 512;
+
+// Smoothing of the per process power shown in the tooltip
+constexpr float g_powerSmoothing = 0.3f;
+
+#ifdef Q_OS_LINUX
+static int openStat(int32_t pid)
+{
+    char path[32];
+    std::snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+
+    return ::open(path, O_RDONLY | O_CLOEXEC);
+}
+#endif
+
+ProcessEnergy::ProcessEnergy()
+{
+}
+
+ProcessEnergy::~ProcessEnergy()
+{
+    clear();
+}
+
+void ProcessEnergy::setTopCount(int32_t topCount)
+{
+    m_topCount = std::max(0, topCount);
+}
+
+void ProcessEnergy::update(int64_t timestamp, float power)
+{
+#ifdef Q_OS_LINUX
+    QElapsedTimer timer;
+    timer.start();
+
+    if (m_updates++ % g_scanInterval == 0)
+        scanProcesses();
+
+    uint64_t busy = 0;
+    if (!readBusyTicks(busy))
+        return;
+
+    uint64_t busyDelta = busy - m_busyTicks;
+    double elapsed = (timestamp - m_lastTimestamp) / 1000.0;
+
+    // The first update only sets the baselines
+    bool attribute = m_busyTicks > 0 && busyDelta > 0 && elapsed > 0.0;
+
+    m_busyTicks = busy;
+    m_lastTimestamp = timestamp;
+
+    m_top.clear();
+
+    for (auto it = m_processes.begin(); it != m_processes.end();)
+    {
+        Process& process = it.value();
+
+        uint64_t ticks = 0;
+        if (!readProcess(it.key(), process, ticks))
+        {
+            closeProcess(process);
+            it = m_processes.erase(it);
+            continue;
+        }
+
+        // A process new since the last update has no delta yet
+        uint64_t delta = process.sampled && ticks >= process.ticks ? ticks - process.ticks : 0;
+        process.ticks = ticks;
+        process.sampled = true;
+
+        float share = attribute ? static_cast<float>(power * std::min(1.0, static_cast<double>(delta) / busyDelta)) : 0.0f;
+
+        process.energy += share * elapsed;
+        process.power += (share - process.power) * g_powerSmoothing;
+
+        if (process.power >= 0.05f)
+            m_top.push_back({ it.key(), process.name, process.power, process.energy });
+
+        ++it;
+    }
+
+    auto end = m_top.begin() + std::min<size_t>(m_topCount, m_top.size());
+    std::partial_sort(m_top.begin(), end, m_top.end(), [](const ProcessPower& a, const ProcessPower& b) { return a.power > b.power; });
+    m_top.erase(end, m_top.end());
+
+    m_lastUpdateTime = timer.nsecsElapsed();
+#else
+    Q_UNUSED(timestamp);
+    Q_UNUSED(power);
+#endif
+}
+
+void ProcessEnergy::clear()
+{
+    for (Process& process : m_processes)
+        closeProcess(process);
+
+    m_processes.clear();
+    m_top.clear();
+
+#ifdef Q_OS_LINUX
+    if (m_statFd >= 0)
+        ::close(m_statFd);
+#endif
+
+    m_statFd = -1;
+    m_busyTicks = 0;
+    m_updates = 0;
+}
+
+const std::vector<ProcessPower>& ProcessEnergy::top() const
+{
+    return m_top;
+}
+
+int32_t ProcessEnergy::processCount() const
+{
+    return m_processes.size();
+}
+
+int64_t ProcessEnergy::lastUpdateTime() const
+{
+    return m_lastUpdateTime;
+}
+
+void ProcessEnergy::scanProcesses()
+{
+#ifdef Q_OS_LINUX
+    DIR* directory = ::opendir("/proc");
+    if (directory == nullptr) return;
+
+    while (dirent* entry = ::readdir(directory))
+    {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9')
+            continue;
+
+        int32_t pid = std::atoi(entry->d_name);
+        if (m_processes.contains(pid))
+            continue;
+
+        Process process;
+        if (m_openFiles < g_maxOpenFiles)
+        {
+            process.fd = openStat(pid);
+            if (process.fd >= 0)
+                ++m_openFiles;
+        }
+
+        m_processes.insert(pid, process);
+    }
+
+    ::closedir(directory);
+#endif
+}
+
+bool ProcessEnergy::readProcess(int32_t pid, Process& process, uint64_t& ticks)
+{
+#ifdef Q_OS_LINUX
+    char buffer[1024];
+    ssize_t length;
+
+    if (process.fd >= 0)
+    {
+        length = ::pread(process.fd, buffer, sizeof(buffer) - 1, 0);
+    }
+    else
+    {
+        int fd = openStat(pid);
+        if (fd < 0) return false;
+
+        length = ::read(fd, buffer, sizeof(buffer) - 1);
+        ::close(fd);
+    }
+
+    // A descriptor of a finished process reads ESRCH
+    if (length <= 0) return false;
+    buffer[length] = '\0';
+
+    // "pid (comm) state ...", comm may contain spaces and parentheses
+    char* nameStart = std::strchr(buffer, '(');
+    char* nameEnd = std::strrchr(buffer, ')');
+    if (nameStart == nullptr || nameEnd == nullptr || nameEnd < nameStart)
+        return false;
+
+    // utime and stime are fields 14 and 15, starttime is 22, the state after
+    // comm is field 3
+    uint64_t values[3] = {};
+    const int32_t fields[3] = { 14, 15, 22 };
+
+    int32_t value = 0;
+    char* field = nameEnd + 2;
+    for (int32_t i = 3; value < 3 && field != nullptr; ++i)
+    {
+        if (i == fields[value])
+            values[value++] = std::strtoull(field, nullptr, 10);
+
+        field = std::strchr(field, ' ');
+        if (field != nullptr)
+            ++field;
+    }
+
+    if (value < 3)
+        return false;
+
+    // A pid read by path may belong to a new process by now
+    if (values[2] != process.startTime)
+    {
+        process.startTime = values[2];
+        process.sampled = false;
+        process.name = QByteArray(nameStart + 1, nameEnd - nameStart - 1);
+        process.power = 0.0f;
+        process.energy = 0.0;
+    }
+
+    ticks = values[0] + values[1];
+    return true;
+#else
+    Q_UNUSED(pid);
+    Q_UNUSED(process);
+    Q_UNUSED(ticks);
+    return false;
+#endif
+}
+
+bool ProcessEnergy::readBusyTicks(uint64_t& busy)
+{
+#ifdef Q_OS_LINUX
+    if (m_statFd < 0)
+        m_statFd = ::open("/proc/stat", O_RDONLY | O_CLOEXEC);
+
+    if (m_statFd < 0) return false;
+
+    char buffer[256];
+    ssize_t length = ::pread(m_statFd, buffer, sizeof(buffer) - 1, 0);
+    if (length <= 0) return false;
+    buffer[length] = '\0';
+
+    // cpu user nice system idle iowait irq softirq steal
+    unsigned long long values[8] = {};
+    if (std::sscanf(buffer, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+                    &values[0], &values[1], &values[2], &values[3], &values[4], &values[5], &values[6], &values[7]) < 4)
+        return false;
+
+    busy = values[0] + values[1] + values[2] + values[5] + values[6] + values[7];
+    return true;
+#else
+    Q_UNUSED(busy);
+    return false;
+#endif
+}
+
+void ProcessEnergy::closeProcess(Process& process)
+{
+#ifdef Q_OS_LINUX
+    if (process.fd >= 0)
+    {
+        ::close(process.fd);
+        --m_openFiles;
+    }
+#endif
+
+    process.fd = -1;
+}
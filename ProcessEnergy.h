@@ -0,0 +1,70 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+#include <cstdint>
+#include <vector>
+
+struct ProcessPower
+{
+    int32_t pid = 0;
+    QByteArray name;
+    float power = 0.0f;
+    double energy = 0.0;
+};
+
+// Splits the socket power between processes by their CPU time. Every sample
+// reads utime + stime from /proc/[pid]/stat of the known processes through
+// descriptors kept open, /proc itself is only listed every few samples to
+// pick up new ones, and a process whose stat can no longer be read is gone.
+// Power is shared in proportion to the busy time of /proc/stat, so idle time
+// is nobody's.
+class ProcessEnergy
+{
+public:
+    ProcessEnergy();
+    ~ProcessEnergy();
+
+    void setTopCount(int32_t topCount);
+
+    // timestamp in ms, power in W
+    void update(int64_t timestamp, float power);
+    void clear();
+
+    // Sorted by power, highest first
+    const std::vector<ProcessPower>& top() const;
+
+    int32_t processCount() const;
+    int64_t lastUpdateTime() const;
+
+private:
+    struct Process
+    {
+        int fd = -1;
+        bool sampled = false;
+        uint64_t ticks = 0;
+        uint64_t startTime = 0;
+        QByteArray name;
+        float power = 0.0f;
+        double energy = 0.0;
+    };
+
+    void scanProcesses();
+    bool readProcess(int32_t pid, Process& process, uint64_t& ticks);
+    bool readBusyTicks(uint64_t& busy);
+    void closeProcess(Process& process);
+
+    QHash<int32_t, Process> m_processes;
+    std::vector<ProcessPower> m_top;
+    int32_t m_topCount = 5;
+
+    int m_statFd = -1;
+    uint64_t m_busyTicks = 0;
+
+    int64_t m_lastTimestamp = 0;
+    int32_t m_updates = 0;
+    int32_t m_openFiles = 0;
+    int64_t m_lastUpdateTime = 0;
+};
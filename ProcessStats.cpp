@@ -0,0 +1,50 @@
+#include "ProcessStats.h"
+
+#include <QtGlobal>
+
+#include <cstdio>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+int64_t residentMemory()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+
+    return static_cast<int64_t>(counters.WorkingSetSize / 1024);
+#elif defined(Q_OS_LINUX)
+    FILE* file = std::fopen("/proc/self/statm", "r");
+    if (file == nullptr)
+        return 0;
+
+    long size = 0;
+    long resident = 0;
+    int count = std::fscanf(file, "%ld %ld", &size, &resident);
+    std::fclose(file);
+
+    if (count != 2)
+        return 0;
+
+    return static_cast<int64_t>(resident) * sysconf(_SC_PAGESIZE) / 1024;
+#else
+    return 0;
+#endif
+}
+
+bool reportStartupProbe(int64_t elapsed)
+{
+    if (!qEnvironmentVariableIsSet("REDMIOSD_STARTUP_PROBE"))
+        return false;
+
+    std::printf("%lld %lld\n", static_cast<long long>(elapsed), static_cast<long long>(residentMemory()));
+    std::fflush(stdout);
+
+    return true;
+}
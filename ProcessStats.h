@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// Resident set size of the current process in KiB, 0 if unknown
+int64_t residentMemory();
+
+// redmiosd_bench starts the executables with REDMIOSD_STARTUP_PROBE set to
+// compare the builds. Then prints the time and RSS it reads and returns true,
+// the caller exits before anything touches the hardware.
+bool reportStartupProbe(int64_t elapsed);
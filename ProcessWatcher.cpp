@@ -0,0 +1,416 @@
+#include "ProcessWatcher.h"
+
+#include <QDebug>
+#include <QSocketNotifier>
+
+#include <algorithm>
+#include <utility>
+
+#ifdef Q_OS_LINUX
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Compared numerically, newer kernel headers moved the event enum out of proc_event
+constexpr uint32_t g_procEventExec = 0x00000002;
+constexpr uint32_t g_procEventExit = 0x80000000;
+
+static ssize_t readProcFile(int32_t pid, const char* name, char* buffer, size_t size)
+{
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/%s", pid, name);
+
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    ssize_t length = ::read(fd, buffer, size - 1);
+    ::close(fd);
+
+    if (length < 0) return -1;
+
+    buffer[length] = '\0';
+    return length;
+}
+#endif
+
+// The kernel truncates comm to TASK_COMM_LEN - 1 characters
+constexpr int32_t g_commLength = 15;
+
+ProcessWatcher::ProcessWatcher(QObject* parent)
+    : QObject(parent)
+{
+    connect(&m_scanTimer, &QTimer::timeout, this, &ProcessWatcher::scanProcesses);
+}
+
+ProcessWatcher::~ProcessWatcher()
+{
+    stop();
+}
+
+void ProcessWatcher::setRules(const QList<ProcessRule>& rules)
+{
+    m_rules = rules;
+
+    // Index order is priority order, so the first matching rule always wins
+    std::stable_sort(m_rules.begin(), m_rules.end(), [](const ProcessRule& a, const ProcessRule& b) { return a.priority > b.priority; });
+
+    m_nameRules.clear();
+    m_cgroupRules.clear();
+
+    for (int32_t i = 0; i < m_rules.size(); ++i)
+    {
+        for (const QString& name : m_rules[i].names)
+        {
+            QByteArray key = name.toLocal8Bit().left(g_commLength);
+            if (!m_nameRules.contains(key))
+                m_nameRules.insert(key, i);
+        }
+
+        for (const QString& cgroup : m_rules[i].cgroups)
+            m_cgroupRules.append({ cgroup.toLocal8Bit(), i });
+    }
+
+    m_matches.clear();
+    m_knownPids.clear();
+    m_pendingPids.clear();
+    m_ruleCounts.fill(0, m_rules.size());
+    m_activeRule = -1;
+}
+
+bool ProcessWatcher::start(int32_t scanInterval)
+{
+    stop();
+
+#ifdef Q_OS_LINUX
+    if (m_rules.isEmpty())
+        return false;
+
+    scanProcesses();
+
+    if (connectNetlink())
+    {
+        qDebug() << "Process watcher connected to the process connector.";
+        return true;
+    }
+
+    qDebug() << "Process connector is unavailable, scanning /proc every" << scanInterval << "ms.";
+    m_scanTimer.start(scanInterval);
+    return true;
+#else
+    Q_UNUSED(scanInterval);
+
+    qDebug() << "Process watching is not supported on this platform.";
+    return false;
+#endif
+}
+
+void ProcessWatcher::stop()
+{
+    m_scanTimer.stop();
+    disconnectNetlink();
+}
+
+bool ProcessWatcher::isConnected() const
+{
+    return m_socket >= 0;
+}
+
+void ProcessWatcher::socketActivated()
+{
+#ifdef Q_OS_LINUX
+    alignas(nlmsghdr) char buffer[8192];
+
+    for (;;)
+    {
+        ssize_t size = ::recv(m_socket, buffer, sizeof(buffer), 0);
+        if (size < 0)
+        {
+            // The receive queue overflowed, so some events are lost for good
+            if (errno == ENOBUFS)
+            {
+                scanProcesses();
+                continue;
+            }
+
+            break;
+        }
+
+        if (size == 0)
+            break;
+
+        injectMessage(QByteArray::fromRawData(buffer, static_cast<int>(size)));
+    }
+#endif
+}
+
+void ProcessWatcher::injectMessage(const QByteArray& message)
+{
+#ifdef Q_OS_LINUX
+    int length = static_cast<int>(message.size());
+    for (const nlmsghdr* header = reinterpret_cast<const nlmsghdr*>(message.constData()); NLMSG_OK(header, length); header = NLMSG_NEXT(header, length))
+    {
+        if (header->nlmsg_type != NLMSG_DONE)
+            continue;
+
+        const cn_msg* connectorMessage = reinterpret_cast<const cn_msg*>(NLMSG_DATA(header));
+        if (connectorMessage->id.idx != CN_IDX_PROC || connectorMessage->id.val != CN_VAL_PROC)
+            continue;
+
+        const proc_event* event = reinterpret_cast<const proc_event*>(connectorMessage->data);
+        uint32_t what = static_cast<uint32_t>(event->what);
+
+        if (what == g_procEventExec)
+        {
+            processStarted(event->event_data.exec.process_tgid);
+        }
+        else if (what == g_procEventExit)
+        {
+            // Exit is reported per thread, only the group leader ends the process
+            if (event->event_data.exit.process_pid == event->event_data.exit.process_tgid)
+                processFinished(event->event_data.exit.process_tgid);
+        }
+    }
+#else
+    Q_UNUSED(message);
+#endif
+}
+
+void ProcessWatcher::scanProcesses()
+{
+#ifdef Q_OS_LINUX
+    DIR* directory = ::opendir("/proc");
+    if (directory == nullptr) return;
+
+    QSet<int32_t> pids;
+    pids.reserve(m_knownPids.size() + 64);
+
+    while (dirent* entry = ::readdir(directory))
+    {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9')
+            continue;
+
+        pids.insert(std::atoi(entry->d_name));
+    }
+
+    ::closedir(directory);
+
+    // Not just the known pids, a process seen by the connector since the last
+    // scan may be the one whose exit was lost
+    const QList<int32_t> matchedPids = m_matches.keys();
+    for (int32_t pid : matchedPids)
+    {
+        if (!pids.contains(pid))
+            processFinished(pid);
+    }
+
+    // Only new pids cost a lookup. A pid seen in the previous scan is checked
+    // once more, since it may have been caught between fork and exec
+    QSet<int32_t> pendingPids;
+    for (int32_t pid : std::as_const(pids))
+    {
+        if (!m_knownPids.contains(pid))
+        {
+            processStarted(pid);
+
+            if (!m_matches.contains(pid))
+                pendingPids.insert(pid);
+        }
+        else if (m_pendingPids.contains(pid))
+        {
+            processStarted(pid);
+        }
+    }
+
+    m_knownPids = pids;
+    m_pendingPids = pendingPids;
+#endif
+}
+
+bool ProcessWatcher::connectNetlink()
+{
+#ifdef Q_OS_LINUX
+    m_socket = ::socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (m_socket < 0)
+        return false;
+
+    sockaddr_nl address = {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = CN_IDX_PROC;
+    address.nl_pid = 0;
+
+    if (::bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+    {
+        disconnectNetlink();
+        return false;
+    }
+
+    const proc_cn_mcast_op operation = PROC_CN_MCAST_LISTEN;
+
+    alignas(nlmsghdr) char request[NLMSG_SPACE(sizeof(cn_msg) + sizeof(operation))] = {};
+
+    nlmsghdr* header = reinterpret_cast<nlmsghdr*>(request);
+    header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(operation));
+    header->nlmsg_type = NLMSG_DONE;
+    header->nlmsg_pid = ::getpid();
+
+    cn_msg* message = reinterpret_cast<cn_msg*>(NLMSG_DATA(header));
+    message->id.idx = CN_IDX_PROC;
+    message->id.val = CN_VAL_PROC;
+    message->len = sizeof(operation);
+    std::memcpy(message->data, &operation, sizeof(operation));
+
+    if (::send(m_socket, request, header->nlmsg_len, 0) < 0)
+    {
+        disconnectNetlink();
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &ProcessWatcher::socketActivated);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ProcessWatcher::disconnectNetlink()
+{
+    delete m_notifier;
+    m_notifier = nullptr;
+
+#ifdef Q_OS_LINUX
+    if (m_socket >= 0)
+        ::close(m_socket);
+#endif
+
+    m_socket = -1;
+}
+
+void ProcessWatcher::processStarted(int32_t pid)
+{
+    int32_t rule = matchProcess(pid);
+    int32_t previousRule = m_matches.value(pid, -1);
+
+    if (rule == previousRule)
+        return;
+
+    if (previousRule >= 0)
+        --m_ruleCounts[previousRule];
+
+    if (rule >= 0)
+    {
+        m_matches.insert(pid, rule);
+        ++m_ruleCounts[rule];
+    }
+    else
+    {
+        m_matches.remove(pid);
+    }
+
+    updateMatch();
+}
+
+void ProcessWatcher::processFinished(int32_t pid)
+{
+    auto it = m_matches.find(pid);
+    if (it == m_matches.end())
+        return;
+
+    --m_ruleCounts[it.value()];
+    m_matches.erase(it);
+
+    updateMatch();
+}
+
+int32_t ProcessWatcher::matchProcess(int32_t pid) const
+{
+#ifdef Q_OS_LINUX
+    int32_t rule = -1;
+
+    char buffer[4096];
+    ssize_t length = readProcFile(pid, "comm", buffer, g_commLength + 2);
+    if (length > 0)
+    {
+        if (buffer[length - 1] == '\n')
+            buffer[--length] = '\0';
+
+        rule = m_nameRules.value(QByteArray::fromRawData(buffer, length), -1);
+    }
+
+    if (m_cgroupRules.isEmpty() || rule == 0)
+        return rule;
+
+    // cgroup v2 has a single "0::/path" line
+    length = readProcFile(pid, "cgroup", buffer, sizeof(buffer));
+    if (length <= 0)
+        return rule;
+
+    const char* path = buffer;
+    while (std::strncmp(path, "0::", 3) != 0)
+    {
+        path = std::strchr(path, '\n');
+        if (path == nullptr)
+            return rule;
+
+        ++path;
+    }
+
+    path += 3;
+    size_t pathLength = std::strcspn(path, "\n");
+
+    for (const auto& cgroupRule : m_cgroupRules)
+    {
+        if (rule >= 0 && cgroupRule.second >= rule)
+            continue;
+
+        const QByteArray& prefix = cgroupRule.first;
+        const size_t prefixLength = static_cast<size_t>(prefix.size());
+
+        if (prefixLength > pathLength || std::strncmp(path, prefix.constData(), prefixLength) != 0)
+            continue;
+
+        // Whole path components only, "/app.slice/foo" must not match "/app.slice/foobar"
+        if (prefixLength == pathLength || path[prefixLength] == '/' || prefix.endsWith('/'))
+            rule = cgroupRule.second;
+    }
+
+    return rule;
+#else
+    Q_UNUSED(pid);
+    return -1;
+#endif
+}
+
+void ProcessWatcher::updateMatch()
+{
+    int32_t rule = -1;
+    for (int32_t i = 0; i < m_ruleCounts.size(); ++i)
+    {
+        if (m_ruleCounts[i] > 0)
+        {
+            rule = i;
+            break;
+        }
+    }
+
+    if (rule == m_activeRule)
+        return;
+
+    m_activeRule = rule;
+
+    if (rule < 0)
+        emit presetReleased();
+    else
+        emit presetRequested(m_rules[rule].preset, m_rules[rule].priority);
+}
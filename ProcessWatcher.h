@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+class QSocketNotifier;
+QT_END_NAMESPACE
+
+struct ProcessRule
+{
+    QStringList names;
+    QStringList cgroups;
+    QString preset;
+    int32_t priority = 0;
+};
+
+// Maps running executables (or their cgroups) to presets. Exec/exit events come
+// from the netlink process connector, which needs CAP_NET_ADMIN, otherwise the
+// watcher falls back to diffing the pid list of /proc.
+class ProcessWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProcessWatcher(QObject* parent = nullptr);
+    virtual ~ProcessWatcher();
+
+    void setRules(const QList<ProcessRule>& rules);
+
+    bool start(int32_t scanInterval);
+    void stop();
+
+    // One datagram of the process connector, as it comes from the socket
+    void injectMessage(const QByteArray& message);
+
+    bool isConnected() const;
+
+signals:
+    void presetRequested(const QString& preset, int32_t priority);
+    void presetReleased();
+
+private slots:
+    void socketActivated();
+    void scanProcesses();
+
+private:
+    bool connectNetlink();
+    void disconnectNetlink();
+
+    void processStarted(int32_t pid);
+    void processFinished(int32_t pid);
+
+    int32_t matchProcess(int32_t pid) const;
+    void updateMatch();
+
+    QList<ProcessRule> m_rules;
+    QHash<QByteArray, int32_t> m_nameRules;
+    QList<QPair<QByteArray, int32_t>> m_cgroupRules;
+
+    QHash<int32_t, int32_t> m_matches;
+    QVector<int32_t> m_ruleCounts;
+    QSet<int32_t> m_knownPids;
+    QSet<int32_t> m_pendingPids;
+    int32_t m_activeRule = -1;
+
+    int m_socket = -1;
+    QSocketNotifier* m_notifier = nullptr;
+    QTimer m_scanTimer;
+};
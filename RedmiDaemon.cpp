@@ -0,0 +1,181 @@
+#include "RedmiDaemon.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QSocketNotifier>
+#include <QStringList>
+
+#ifdef REDMIOSD_HOTKEYS
+#include <QHotkey>
+#endif
+
+#include "Trace.h"
+
+#ifdef Q_OS_UNIX
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <csignal>
+#endif
+
+#ifdef Q_OS_UNIX
+static int g_signalSockets[2] = { -1, -1 };
+
+static void handleSignal(int signal)
+{
+    char value = static_cast<char>(signal);
+    ssize_t written = ::write(g_signalSockets[0], &value, sizeof(value));
+    Q_UNUSED(written);
+}
+#endif
+
+RedmiDaemon::RedmiDaemon()
+    : m_engine("Presets.json")
+    , m_controlServer(m_engine)
+    , m_metricsServer(m_engine)
+#ifdef REDMIOSD_DBUS
+    , m_powerProfilesService(m_engine)
+#endif
+{
+    m_engine.readPresets();
+
+    connect(&m_engine, &PresetEngine::presetActivated, this, &RedmiDaemon::presetActivated);
+
+    createSignals();
+    createShortcuts();
+}
+
+RedmiDaemon::~RedmiDaemon()
+{
+#ifdef Q_OS_UNIX
+    ::close(g_signalSockets[0]);
+    ::close(g_signalSockets[1]);
+#endif
+}
+
+bool RedmiDaemon::start()
+{
+    if (!m_controlServer.listen())
+        return false;
+
+    m_engine.initPreset();
+
+    if (m_engine.presets().metrics.enabled)
+        m_metricsServer.listen(static_cast<quint16>(m_engine.presets().metrics.port));
+
+#ifdef REDMIOSD_DBUS
+    if (m_engine.presets().powerProfiles.enabled)
+        m_powerProfilesService.start();
+#endif
+
+    m_engine.start();
+
+    return true;
+}
+
+void RedmiDaemon::signalActivated()
+{
+#ifdef Q_OS_UNIX
+    char value = 0;
+    if (::read(g_signalSockets[1], &value, sizeof(value)) != sizeof(value))
+        return;
+
+    switch (value)
+    {
+        case SIGHUP:
+            m_engine.reload();
+            createShortcuts();
+            break;
+        case SIGUSR1:
+            cyclePreset();
+            break;
+        case SIGUSR2:
+            Trace::dump(QDir::current().absoluteFilePath("redmiosd-trace.json"));
+            break;
+        case SIGINT:
+        case SIGTERM:
+            QCoreApplication::quit();
+            break;
+        default:
+            break;
+    }
+#endif
+}
+
+void RedmiDaemon::presetActivated(const QString& preset)
+{
+    qInfo() << "Active preset:" << preset;
+}
+
+void RedmiDaemon::createSignals()
+{
+#ifdef Q_OS_UNIX
+    // Handlers only write to the socket, the work happens in the event loop
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, g_signalSockets) != 0)
+    {
+        qWarning() << "Failed to create the signal socket pair.";
+        return;
+    }
+
+    m_signalNotifier = new QSocketNotifier(g_signalSockets[1], QSocketNotifier::Read, this);
+    connect(m_signalNotifier, &QSocketNotifier::activated, this, &RedmiDaemon::signalActivated);
+
+    struct sigaction action = {};
+    action.sa_handler = &handleSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    for (int signal : { SIGHUP, SIGUSR1, SIGUSR2, SIGINT, SIGTERM })
+        sigaction(signal, &action, nullptr);
+#endif
+}
+
+void RedmiDaemon::createShortcuts()
+{
+#ifdef REDMIOSD_HOTKEYS
+    QHotkey::unregisterHotkeys(m_shortcuts);
+    qDeleteAll(m_shortcuts);
+    m_shortcuts.clear();
+
+    const Presets& presets = m_engine.presets();
+    for (auto it = presets.shorcutsMap.constBegin(); it != presets.shorcutsMap.constEnd(); ++it)
+    {
+        if (it.value().isEmpty())
+            continue;
+
+        QString preset = it.key();
+
+        QHotkey* shortcut = new QHotkey(QKeySequence(it.value()), false, this);
+        connect(shortcut, &QHotkey::activated, this, [this, preset]() { m_engine.switchPreset(preset); });
+
+        m_shortcuts.append(shortcut);
+    }
+
+    for (auto it = presets.holdShortcutsMap.constBegin(); it != presets.holdShortcutsMap.constEnd(); ++it)
+    {
+        if (it.value().isEmpty())
+            continue;
+
+        QString preset = it.key();
+
+        QHotkey* shortcut = new QHotkey(QKeySequence(it.value()), false, this);
+        connect(shortcut, &QHotkey::activated, this, [this, preset]() { m_engine.holdPreset(preset); });
+        connect(shortcut, &QHotkey::released, this, [this]() { m_engine.releaseHold(); });
+
+        m_shortcuts.append(shortcut);
+    }
+
+    QHotkey::registerHotkeys(m_shortcuts);
+#endif
+}
+
+void RedmiDaemon::cyclePreset()
+{
+    QStringList presets = m_engine.presets().argsMap.keys();
+    if (presets.isEmpty())
+        return;
+
+    int32_t index = presets.indexOf(m_engine.presets().lastPreset);
+    m_engine.switchPreset(presets[(index + 1) % presets.size()]);
+}
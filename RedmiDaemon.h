@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QList>
+#include <QObject>
+
+#include "ControlServer.h"
+#include "MetricsServer.h"
+#include "PresetEngine.h"
+
+#ifdef REDMIOSD_DBUS
+#include "PowerProfilesService.h"
+#endif
+
+QT_BEGIN_NAMESPACE
+class QSocketNotifier;
+QT_END_NAMESPACE
+
+class QHotkey;
+
+// Headless front end of the preset engine. It is driven by Presets.json,
+// Unix signals and, where the platform allows it without a GUI, hotkeys:
+//   SIGHUP  - reload Presets.json
+//   SIGUSR1 - switch to the next preset
+//   SIGINT, SIGTERM - quit
+class RedmiDaemon : public QObject
+{
+    Q_OBJECT
+
+public:
+    RedmiDaemon();
+    virtual ~RedmiDaemon();
+
+    // Applies the last preset and starts the servers, the constructor only
+    // reads Presets.json. False if the control socket can't be had, e.g.
+    // when another instance holds it
+    bool start();
+
+private slots:
+    void signalActivated();
+    void presetActivated(const QString& preset);
+
+private:
+    void createSignals();
+    void createShortcuts();
+    void cyclePreset();
+
+    PresetEngine m_engine;
+    ControlServer m_controlServer;
+    MetricsServer m_metricsServer;
+
+#ifdef REDMIOSD_DBUS
+    PowerProfilesService m_powerProfilesService;
+#endif
+
+    QList<QHotkey*> m_shortcuts;
+    QSocketNotifier* m_signalNotifier = nullptr;
+};
@@ -15,72 +15,38 @@
 #include <QTextEdit>
 #include <QVBoxLayout>
 #include <QMessageBox>
-#include <QProcess>
 #include <QStringList>
 #include <QKeySequenceEdit>
 #include <QTimer>
-#include <QFile>
-#include <QJsonDocument>
-#include <QJsonArray>
-#include <QJsonObject>
-#include <QDateTime>
 #include <QDesktopServices>
-#include <QStandardPaths>
-#include <QFileInfo>
-#include <QDir>
+#include <QUrl>
 
-#include <functional>
-#include <sstream> 
-
-#include <windows.h>
-
-int32_t g_fastCache = 0;
-
-int32_t g_slowCache = 0;
-
-ryzen_access g_ryzen;
-
-QMap<QString, std::function<void(ryzen_access, int32_t)>> g_ryzenMapper
-{
-    { "stapm-limit", &set_stapm_limit },
-    { "fast-limit", &set_fast_limit },
-    { "slow-limit", &set_slow_limit },
-    { "slow-time", &set_slow_time },
-    { "stapm-time", &set_stapm_time },
-    { "tctl-temp", &set_tctl_temp },
-    { "vrm-current", &set_vrm_current },
-    { "vrmsoc-current", &set_vrmsoc_current },
-    { "vrmmax-current", &set_vrmmax_current},
-    { "vrmsocmax-current", &set_vrmsocmax_current },
-    { "psi0-current", &set_psi0_current },
-    { "psi0soc-current", &set_psi0soc_current },
-    { "max-socclk-frequency", &set_max_socclk_freq },
-    { "min-socclk-frequency", &set_min_socclk_freq },
-    { "max-fclk-frequency", &set_max_fclk_freq },
-    { "min-fclk-frequency", &set_min_fclk_freq },
-    { "max-vcn", &set_max_vcn },
-    { "min-vcn", &set_min_vcn },
-    { "max-lclk", &set_max_lclk },
-    { "min-lclk", &set_min_lclk },
-    { "max-gfxclk", &set_max_gfxclk_freq },
-    { "min-gfxclk", &set_min_gfxclk_freq },
-    { "prochot-deassertion-ramp", &set_prochot_deassertion_ramp },
-    { "apu-skin-temp", &set_apu_skin_temp_limit },
-    { "dgpu-skin-temp", &set_dgpu_skin_temp_limit },
-    { "apu-slow-limit", &set_apu_slow_limit },
-    { "skin-temp-limit", &set_skin_temp_power_limit },
-};
+#include "Trace.h"
 
 RedmiOSD::RedmiOSD()
+    : m_startupEntry(createStartupEntry("RedmiOSD"))
+    , m_engine("Presets.json")
+    , m_presets(m_engine.presets())
+    , m_controlServer(m_engine)
+    , m_metricsServer(m_engine)
+#ifdef REDMIOSD_DBUS
+    , m_powerProfilesService(m_engine)
+#endif
 {
-    readPresets(m_filePath);
-    
-    initPreset();
+    m_engine.readPresets();
+
+    m_icons.preload(QStringList{ "Default", "Quit" } << m_presets.argsMap.keys());
 
     createWindow();
     createTray();
     createShortcuts();
 
+    QStringList overlayMessages;
+    for (const QString& preset : m_presets.argsMap.keys())
+        overlayMessages.append(formatToUpper(preset));
+
+    m_overlay.preload(overlayMessages);
+
     connect(m_trayIcon, &QSystemTrayIcon::activated, this, &RedmiOSD::trayActivated);
     
     connect(m_defaultComboBox, &QComboBox::currentTextChanged, this, &RedmiOSD::defaultComboBoxChanged);
@@ -101,27 +67,43 @@ RedmiOSD::RedmiOSD()
     connect(&m_silenceShortcut, &QHotkey::activated, this, &RedmiOSD::silenceButtonClicked);
     connect(&m_turboShortcut, &QHotkey::activated, this, &RedmiOSD::turboButtonClicked);
     
-    connect(&m_updatePresetTimer, &QTimer::timeout, this, &RedmiOSD::updatePreset);
     connect(&m_updateLiveEditTimer, &QTimer::timeout, this, &RedmiOSD::updateLiveEdit);
 
-    applyPreset(m_presets.argsMap[m_presets.lastPreset]);
-    applyStartup(m_presets.startup);
+    connect(&m_engine, &PresetEngine::presetApplying, this, &RedmiOSD::presetApplying);
+    connect(&m_engine, &PresetEngine::presetActivated, this, &RedmiOSD::presetActivated);
+    connect(&m_engine, &PresetEngine::presetFailed, this, &RedmiOSD::presetFailed);
+    connect(&m_engine, &PresetEngine::telemetryUpdated, this, &RedmiOSD::telemetryUpdated);
+}
 
-    if (m_presets.showOverlay)
-        showOSD(formatToUpper(m_presets.lastPreset));
+RedmiOSD::~RedmiOSD()
+{
+}
+
+bool RedmiOSD::start()
+{
+    if (!m_controlServer.listen())
+        return false;
+
+    m_engine.initPreset();
+
+    if (m_presets.metrics.enabled)
+        m_metricsServer.listen(static_cast<quint16>(m_presets.metrics.port));
+
+#ifdef REDMIOSD_DBUS
+    if (m_presets.powerProfiles.enabled)
+        m_powerProfilesService.start();
+#endif
+
+    m_engine.start();
+    m_startupEntry->setEnabled(m_presets.startup);
 
     if (m_presets.showTray)
         m_trayIcon->show();
 
     if (m_presets.liveEdit) 
         m_updateLiveEditTimer.start(1000);
-    
-    m_updatePresetTimer.start(m_presets.updateRate);
-}
 
-RedmiOSD::~RedmiOSD()
-{
-    cleanup_ryzenadj(g_ryzen);
+    return true;
 }
 
 void RedmiOSD::closeEvent(QCloseEvent *event)
@@ -155,32 +137,28 @@ void RedmiOSD::trayActivated(QSystemTrayIcon::ActivationReason reason)
 void RedmiOSD::defaultComboBoxChanged(const QString& text)
 {
     m_presets.defaultPreset = formatToLower(text);
-    writePresets(m_filePath);
+    m_engine.writePresets();
 }
 
 void RedmiOSD::updateRateTimeSpinBoxChanged(int value)
 {
-    m_presets.updateRate = value;
-    writePresets(m_filePath);
-
-    m_updatePresetTimer.stop();
-    m_updatePresetTimer.start(m_presets.updateRate);
+    m_engine.setUpdateRate(value);
 }
 
 void RedmiOSD::startupCheckBoxToggled(bool checked)
 {
     m_presets.startup = checked;
-    writePresets(m_filePath);
+    m_engine.writePresets();
 
-    applyStartup(checked);
+    m_startupEntry->setEnabled(checked);
 }
 
 void RedmiOSD::liveEditCheckBoxToggled(bool checked)
 {
-    readPresets(m_filePath);
+    m_engine.readPresets();
     
     m_presets.liveEdit = checked;
-    writePresets(m_filePath);
+    m_engine.writePresets();
 
     if (checked)
         m_updateLiveEditTimer.start(1000);
@@ -191,60 +169,42 @@ void RedmiOSD::liveEditCheckBoxToggled(bool checked)
 void RedmiOSD::overlayCheckBoxToggled(bool checked)
 {
     m_presets.showOverlay = checked;
-    writePresets(m_filePath);
+    m_engine.writePresets();
 }
 
 void RedmiOSD::trayCheckBoxToggled(bool checked)
 {
     m_presets.showTray = checked;
-    writePresets(m_filePath);
+    m_engine.writePresets();
 
-    m_trayIcon->setIcon(QIcon(QString("Resources/%1.png").arg(formatToUpper(m_presets.lastPreset))));
-    m_trayIcon->setToolTip(formatToUpper(m_presets.lastPreset));
+    updateTrayIcon();
+    m_trayIcon->setToolTip(formatToUpper(m_engine.activePreset()));
     m_trayIcon->setVisible(checked);
 }
 
 void RedmiOSD::presetsButtonClicked()
 {
-    QDesktopServices::openUrl(QUrl(m_filePath));
+    QDesktopServices::openUrl(QUrl(m_engine.filePath()));
 }
 
 void RedmiOSD::silenceButtonClicked()
 {
-    m_presets.lastPreset = "silence";
-    writePresets(m_filePath);
+    REDMIOSD_TRACE("hotkey", "silence");
 
-    applyPreset(m_presets.argsMap["silence"]);
-
-    if (m_presets.showOverlay)
-        showOSD("Silence");
-
-    m_activeLabel->setText("Silence");
-
-    m_trayIcon->setIcon(QIcon("Resources/Silence.png"));
-    m_trayIcon->setToolTip("Silence");
+    m_engine.switchPreset("silence");
 }
 
 void RedmiOSD::turboButtonClicked()
 {
-    m_presets.lastPreset = "turbo";
-    writePresets(m_filePath);
-
-    applyPreset(m_presets.argsMap["turbo"]);
-
-    if (m_presets.showOverlay)
-        showOSD("Turbo");
-
-    m_activeLabel->setText("Turbo");
+    REDMIOSD_TRACE("hotkey", "turbo");
 
-    m_trayIcon->setIcon(QIcon("Resources/Turbo.png"));
-    m_trayIcon->setToolTip("Turbo");
+    m_engine.switchPreset("turbo");
 }
 
 void RedmiOSD::silenceKeySequenceFinished()
 {
     m_presets.shorcutsMap["silence"] = m_silenceKeySequence->keySequence().toString();
-    writePresets(m_filePath);
+    m_engine.writePresets();
     
     m_silenceShortcut.setShortcut(QKeySequence(m_presets.shorcutsMap["silence"]), true);
     m_silenceKeySequence->clearFocus();
@@ -253,264 +213,102 @@ void RedmiOSD::silenceKeySequenceFinished()
 void RedmiOSD::turboKeySequenceFinished()
 {
     m_presets.shorcutsMap["turbo"] = m_turboKeySequence->keySequence().toString();
-    writePresets(m_filePath);
+    m_engine.writePresets();
 
     m_turboShortcut.setShortcut(QKeySequence(m_presets.shorcutsMap["turbo"]), true);
     m_turboKeySequence->clearFocus();
 }
 
-void RedmiOSD::readPresets(const QString& filePath)
+void RedmiOSD::presetApplying(const QString& preset)
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) 
-    {
-        qDebug() << "Failed to open file:" << file.errorString();
-        return;
-    }
-
-    QByteArray jsonData = file.readAll();
-    file.close();
-
-    QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData);
-    if (jsonDoc.isNull() || !jsonDoc.isObject()) 
-    {
-        qDebug() << "Invalid JSON data.";
-        return;
-    }
-
-    QJsonObject rootObject = jsonDoc.object();
+    REDMIOSD_TRACE("osd.show");
 
-    if (!rootObject.contains("defaultPreset"))
-    {
-        qDebug() << "Default preset not found in JSON.";
-        return;
-    }
-
-    if (!rootObject.contains("lastPreset"))
-    {
-        qDebug() << "Last preset not found in JSON.";
-        return;
-    }
-
-    if (!rootObject.contains("presets"))
-    {
-        qDebug() << "Presets array not found in JSON.";
-        return;
-    }
-
-    m_presets.defaultPreset = rootObject["defaultPreset"].toString();
-    m_presets.lastPreset = rootObject["lastPreset"].toString();
-    m_presets.updateRate = rootObject["updateRate"].toInt();
-    m_presets.startup = rootObject["startup"].toBool();
-    m_presets.liveEdit = rootObject["liveEdit"].toBool();
-    m_presets.showTray = rootObject["showTray"].toBool();
-    m_presets.showOverlay = rootObject["showOverlay"].toBool();
-
-    QJsonArray presetsArray = rootObject["presets"].toArray();
-    for (const QJsonValue& presetValue : presetsArray) 
-    {
-        if (!presetValue.isObject()) 
-        {
-            qDebug() << "Invalid preset format.";
-            continue;
-        }
-
-        QJsonObject presetObject = presetValue.toObject();
-        QString presetName = presetObject["name"].toString();
-        QString shortcut = presetObject["shortcut"].toString();
-        
-        QJsonObject argsObject = presetObject["args"].toObject();
-        
-        QMap<QString, int32_t> argsMap;
-
-        for (auto it = argsObject.constBegin(); it != argsObject.constEnd(); ++it)
-            argsMap.insert(it.key(), it.value().toInt());
-        
-        m_presets.argsMap.insert(presetName, argsMap);
-        m_presets.shorcutsMap.insert(presetName, shortcut);
-    }
-
-    qDebug() << "File read successfully:" << filePath;
+    if (m_presets.showOverlay)
+        m_overlay.showMessage(formatToUpper(preset));
 }
 
-void RedmiOSD::writePresets(const QString& filePath)
+void RedmiOSD::presetActivated(const QString& preset)
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadWrite | QIODevice::Text))
-    {
-        qDebug() << "Failed to open file:" << file.errorString();
-        return;
-    }
-
-    QByteArray jsonData = file.readAll();
-    file.close();
-
-    QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData);
-    if (jsonDoc.isNull() || !jsonDoc.isObject())
-    {
-        qDebug() << "Invalid JSON data.";
-        return;
-    }
+    m_activeLabel->setText(formatToUpper(preset));
 
-    QJsonObject rootObject = jsonDoc.object();
-
-    QJsonArray presetsArray = rootObject["presets"].toArray();
-    for (QJsonValueRef presetValue : presetsArray)
-    {
-        if (!presetValue.isObject())
-        {
-            qDebug() << "Invalid preset format.";
-            continue;
-        }
-
-        QJsonObject presetObject = presetValue.toObject();
-        QString presetName = presetObject["name"].toString();
-        
-        presetObject["shortcut"] = m_presets.shorcutsMap[presetName];
-        presetValue = presetObject;
-    }
-
-    rootObject["presets"] = presetsArray;
-    rootObject["defaultPreset"] = m_presets.defaultPreset;
-    rootObject["lastPreset"] = m_presets.lastPreset;
-    rootObject["updateRate"] = m_presets.updateRate;
-    rootObject["startup"] = m_presets.startup;
-    rootObject["liveEdit"] = m_presets.liveEdit;
-    rootObject["showTray"] = m_presets.showTray;
-    rootObject["showOverlay"] = m_presets.showOverlay;
-
-    jsonDoc.setObject(rootObject);
-
-    file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate);
-    if (!file.isOpen())
-    {
-        qDebug() << "Failed to open file for writing:" << file.errorString();
-        return;
-    }
-
-    file.write(jsonDoc.toJson());
-    file.close();
-
-    qDebug() << "File write successfully:" << filePath;
+    updateTrayIcon();
+    m_trayIcon->setToolTip(formatToUpper(preset));
 }
 
-void RedmiOSD::initPreset()
+void RedmiOSD::presetFailed(const QString& preset)
 {
-    if (m_presets.defaultPreset != m_presets.lastPreset && m_presets.defaultPreset != "lastPreset")
-    {
-        m_presets.lastPreset = m_presets.defaultPreset;
-        writePresets(m_filePath);
-    }
-
-    g_ryzen = init_ryzenadj();
+    if (m_presets.showOverlay)
+        m_overlay.showMessage(formatToUpper(preset), true);
 }
 
-void RedmiOSD::applyPreset(const QMap<QString, int32_t>& args)
+void RedmiOSD::telemetryUpdated()
 {
-    if (g_ryzen == nullptr) return;
-
-    qDebug() << "\nApplied with ryzenadj at" << QDateTime::currentDateTime().toString();
-    
-    for (auto it = args.begin(); it != args.end(); ++it)
-    {
-        if (g_ryzenMapper.contains(it.key()))
-        {
-            g_ryzenMapper[it.key()](g_ryzen, it.value());
-
-            qDebug() << it.key() << ":" << it.value();
-        }
-    }
-
-    if (args.contains("battery-saver"))
-    {
-        QString command = QString(
-            "powercfg /setdcvalueindex SCHEME_CURRENT SUB_ENERGYSAVER ESBATTTHRESHOLD %1 && "
-            "powercfg /setdcvalueindex SCHEME_CURRENT SUB_ENERGYSAVER ESBRIGHTNESS 100 && "
-            "powercfg /setactive SCHEME_CURRENT").arg(args["battery-saver"]);
+    if ((m_presets.trayValue == "none" && !m_presets.processEnergy.enabled) || !m_trayIcon->isVisible())
+        return;
 
-        QProcess process;
-        process.setProcessChannelMode(QProcess::MergedChannels);
+    // The tray does not need more than a few updates per second
+    if (m_trayUpdateTimer.isValid() && m_trayUpdateTimer.elapsed() < m_presets.trayInterval)
+        return;
 
-        process.start("cmd.exe", QStringList() << "/C" << command);
-        process.waitForFinished(-1);
-    }
+    m_trayUpdateTimer.start();
 
-    refresh_table(g_ryzen);
+    if (m_presets.processEnergy.enabled)
+        m_trayIcon->setToolTip(formatToolTip());
 
-    g_fastCache = get_fast_limit(g_ryzen);
-    g_slowCache = get_slow_limit(g_ryzen);
-}
+    if (m_presets.trayValue == "none")
+        return;
 
-void RedmiOSD::applyStartup(bool enable)
-{
-    QString startupPath = QStandardPaths::writableLocation(QStandardPaths::ApplicationsLocation) + QDir::toNativeSeparators("/Startup");
+    const Telemetry& telemetry = m_engine.telemetry();
+    float value = m_presets.trayValue == "temperature" ? telemetry.tctlTemp : telemetry.socketPower;
 
-    if (enable)
-    {
-        QFileInfo fileInfo(QCoreApplication::applicationFilePath());
-        QString linkPath = startupPath + QDir::toNativeSeparators("/") + fileInfo.completeBaseName() + ".lnk";
-        QFile::link(QCoreApplication::applicationFilePath(), linkPath);
-    }
-    else
-    {
-        QString linkPath = startupPath + QDir::toNativeSeparators("/") + "RedmiOSD.lnk";
-        QFile::remove(linkPath);
-    }
+    QIcon icon;
+    if (m_trayRenderer.render(qRound(value), icon))
+        m_trayIcon->setIcon(icon);
 }
 
-void RedmiOSD::showOSD(const QString& message)
+void RedmiOSD::updateLiveEdit()
 {
-    QDialog* dialog = new QDialog();
-    dialog->setWindowFlags(Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint | Qt::Tool);
-    dialog->setAttribute(Qt::WA_TransparentForMouseEvents);
-    dialog->setAttribute(Qt::WA_TranslucentBackground);
-    dialog->setFixedSize(200, 200);
-
-    QLabel* label = new QLabel(message, dialog);
-    label->setAlignment(Qt::AlignCenter);
-    label->setStyleSheet("font-size: 24pt;");
+    m_engine.reload();
 
-    QVBoxLayout* layout = new QVBoxLayout(dialog);
-    layout->addWidget(label);
-    dialog->setLayout(layout);
+    m_activeLabel->setText(formatToUpper(m_engine.activePreset()));
+    m_defaultComboBox->setCurrentText(formatToUpper(m_presets.defaultPreset));
+    m_updateRateSpinBox->setValue(m_presets.updateRate);
+    m_startupCheckBox->setChecked(m_presets.startup);
+    m_liveEditCheckBox->setChecked(m_presets.liveEdit);
+    m_overlayCheckBox->setChecked(m_presets.showOverlay);
+    m_trayCheckBox->setChecked(m_presets.showTray);
 
-    dialog->setStyleSheet("background-color: rgba(0, 0, 0, 150); color: white;");
+    m_silenceKeySequence->setKeySequence(m_presets.shorcutsMap["silence"]);
+    m_turboKeySequence->setKeySequence(m_presets.shorcutsMap["turbo"]);
 
-    dialog->show();
-    QTimer::singleShot(1000, dialog, &QDialog::deleteLater);
+    updateTrayIcon();
+    m_trayIcon->setToolTip(formatToUpper(m_engine.activePreset()));
+    m_trayIcon->setVisible(m_presets.showTray);
 }
 
-void RedmiOSD::updatePreset()
+QString RedmiOSD::formatToolTip() const
 {
-    if (g_ryzen == nullptr) return;
-
-    refresh_table(g_ryzen);
+    QString toolTip = formatToUpper(m_engine.activePreset());
 
-    int32_t fastCurrent = get_fast_limit(g_ryzen);
-    int32_t slowCurrent = get_slow_limit(g_ryzen);
+    // Where the socket power goes, by CPU time
+    for (const ProcessPower& process : m_engine.processEnergy().top())
+        toolTip += QString("\n%1 %2 W").arg(QString::fromUtf8(process.name)).arg(process.power, 0, 'f', 1);
 
-    if (g_fastCache != fastCurrent || g_slowCache != slowCurrent)
-        applyPreset(m_presets.argsMap[m_presets.lastPreset]);
+    return toolTip;
 }
 
-void RedmiOSD::updateLiveEdit()
+void RedmiOSD::updateTrayIcon()
 {
-    readPresets(m_filePath);
+    const QIcon& presetIcon = m_icons.icon(m_engine.activePreset());
+    m_trayIcon->setIcon(presetIcon);
 
-    m_activeLabel->setText(formatToUpper(m_presets.lastPreset));
-    m_defaultComboBox->setCurrentText(formatToUpper(m_presets.defaultPreset));
-    m_updateRateSpinBox->setValue(m_presets.updateRate);
-    m_startupCheckBox->setChecked(m_presets.startup);
-    m_liveEditCheckBox->setChecked(m_presets.liveEdit);
-    m_overlayCheckBox->setChecked(m_presets.showOverlay);
-    m_trayCheckBox->setChecked(m_presets.showTray);
+    if (m_presets.trayValue == "none")
+        return;
 
-    m_silenceKeySequence->setKeySequence(m_presets.shorcutsMap["silence"]);
-    m_turboKeySequence->setKeySequence(m_presets.shorcutsMap["turbo"]);
+    m_trayRenderer.setBackground(presetIcon);
+    m_trayUpdateTimer.invalidate();
 
-    m_trayIcon->setIcon(QIcon(QString("Resources/%1.png").arg(formatToUpper(m_presets.lastPreset))));
-    m_trayIcon->setToolTip(formatToUpper(m_presets.lastPreset));
-    m_trayIcon->setVisible(m_presets.showTray);
+    telemetryUpdated();
 }
 
 void RedmiOSD::createWindow()
@@ -583,7 +381,7 @@ void RedmiOSD::createWindow()
 
     QLabel* silenceLabel = new QLabel();
     silenceLabel->setFixedSize(24, 24);
-    silenceLabel->setStyleSheet("QLabel { background-color : transparent; image: url(Resources/Silence.png); }");
+    silenceLabel->setPixmap(m_icons.icon("silence").pixmap(24, 24));
     horizontalLayout3->addWidget(silenceLabel);
     horizontalLayout3->addWidget(m_silenceButton);
     horizontalLayout3->addWidget(m_silenceKeySequence);
@@ -591,7 +389,7 @@ void RedmiOSD::createWindow()
 
     QLabel* turboLabel = new QLabel();
     turboLabel->setFixedSize(24, 24);
-    turboLabel->setStyleSheet("QLabel { background-color : transparent; image: url(Resources/Turbo.png); }");
+    turboLabel->setPixmap(m_icons.icon("turbo").pixmap(24, 24));
     horizontalLayout4->addWidget(turboLabel);
     horizontalLayout4->addWidget(m_turboButton);
     horizontalLayout4->addWidget(m_turboKeySequence);
@@ -605,7 +403,7 @@ void RedmiOSD::createWindow()
     mainLayout->addSpacerItem(new QSpacerItem(0, 5));
     mainLayout->addLayout(horizontalLayout4);
 
-    setWindowIcon(QIcon("Resources/Default.png"));
+    setWindowIcon(m_icons.icon("Default"));
     setWindowTitle("RedmiOSD");
     setFixedSize(415, 150);
     setLayout(mainLayout);
@@ -613,10 +411,10 @@ void RedmiOSD::createWindow()
 
 void RedmiOSD::createTray()
 {
-    QAction* settingsAction = new QAction(QIcon("Resources/Default.png"), "Settings", this);
+    QAction* settingsAction = new QAction(m_icons.icon("Default"), "Settings", this);
     connect(settingsAction, &QAction::triggered, this, &QWidget::show);
 
-    QAction* quitAction = new QAction(QIcon("Resources/Quit.png"), "Quit", this);
+    QAction* quitAction = new QAction(m_icons.icon("Quit"), "Quit", this);
     connect(quitAction, &QAction::triggered, qApp, &QCoreApplication::quit);
 
     QMenu* trayIconMenu = new QMenu(this);
@@ -627,14 +425,36 @@ void RedmiOSD::createTray()
     m_trayIcon = new QSystemTrayIcon(this);
     m_trayIcon->setContextMenu(trayIconMenu);
 
-    m_trayIcon->setIcon(QIcon(QString("Resources/%1.png").arg(formatToUpper(m_presets.lastPreset))));
+    m_trayIcon->setIcon(m_icons.icon(m_presets.lastPreset));
     m_trayIcon->setToolTip(formatToUpper(m_presets.lastPreset));
 }
 
 void RedmiOSD::createShortcuts()
 {
-    m_silenceShortcut.setShortcut(QKeySequence(m_presets.shorcutsMap["silence"]), true);
-    m_turboShortcut.setShortcut(QKeySequence(m_presets.shorcutsMap["turbo"]), true);
+    m_silenceShortcut.setShortcut(QKeySequence(m_presets.shorcutsMap["silence"]));
+    m_turboShortcut.setShortcut(QKeySequence(m_presets.shorcutsMap["turbo"]));
+
+    QHotkey::unregisterHotkeys(m_holdShortcuts);
+    qDeleteAll(m_holdShortcuts);
+    m_holdShortcuts.clear();
+
+    // Held keys switch to the preset until they are released
+    for (auto it = m_presets.holdShortcutsMap.constBegin(); it != m_presets.holdShortcutsMap.constEnd(); ++it)
+    {
+        if (it.value().isEmpty())
+            continue;
+
+        QString preset = it.key();
+
+        QHotkey* shortcut = new QHotkey(QKeySequence(it.value()), false, this);
+        connect(shortcut, &QHotkey::activated, this, [this, preset]() { m_engine.holdPreset(preset); });
+        connect(shortcut, &QHotkey::released, this, [this]() { m_engine.releaseHold(); });
+
+        m_holdShortcuts.append(shortcut);
+    }
+
+    // Grabbed in one batch, a single round trip to the window system
+    QHotkey::registerHotkeys(QList<QHotkey*>{ &m_silenceShortcut, &m_turboShortcut } + m_holdShortcuts);
 }
 
 QString RedmiOSD::formatToUpper(const QString& text)
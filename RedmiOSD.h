@@ -3,9 +3,22 @@
 #include <QSystemTrayIcon>
 #include <QDialog>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QHotkey>
 
-#include <ryzenadj.h>
+#include <memory>
+
+#include "ControlServer.h"
+#include "IconCache.h"
+#include "MetricsServer.h"
+#include "OverlayWindow.h"
+#include "Platform.h"
+#include "PresetEngine.h"
+#include "TrayIconRenderer.h"
+
+#ifdef REDMIOSD_DBUS
+#include "PowerProfilesService.h"
+#endif
 
 QT_BEGIN_NAMESPACE
 class QLabel;
@@ -20,19 +33,6 @@ class QTimer;
 class QProcess;
 QT_END_NAMESPACE
 
-struct Presets
-{
-    QMap<QString, QMap<QString, int32_t>> argsMap;
-    QMap<QString, QString> shorcutsMap;
-    QString defaultPreset;
-    QString lastPreset;
-    int32_t updateRate;
-    bool startup;
-    bool liveEdit;
-    bool showTray;
-    bool showOverlay;
-};
-
 class RedmiOSD : public QDialog
 {
     Q_OBJECT
@@ -41,6 +41,11 @@ public:
     RedmiOSD();
     virtual ~RedmiOSD();
 
+    // Applies the last preset, starts the servers and shows the tray, the
+    // constructor only reads Presets.json and builds the widgets. False if
+    // the control socket can't be had, e.g. when another instance holds it
+    bool start();
+
 protected:
     void closeEvent(QCloseEvent *event) override;
 
@@ -62,17 +67,15 @@ private slots:
     void silenceKeySequenceFinished();
     void turboKeySequenceFinished();
 
+    void presetApplying(const QString& preset);
+    void presetActivated(const QString& preset);
+    void presetFailed(const QString& preset);
+    void telemetryUpdated();
+
 private:
-    void readPresets(const QString& filePath);
-    void writePresets(const QString& filePath);
-    
-    void initPreset();
-    void applyPreset(const QMap<QString, int32_t>& args);
-    void applyStartup(bool enable);
-    void showOSD(const QString& message);
-    
-    void updatePreset();
     void updateLiveEdit();
+    void updateTrayIcon();
+    QString formatToolTip() const;
 
     void createWindow();
     void createTray();
@@ -102,10 +105,25 @@ private:
     
     QHotkey m_silenceShortcut;
     QHotkey m_turboShortcut;
+    QList<QHotkey*> m_holdShortcuts;
 
-    QTimer m_updatePresetTimer;
     QTimer m_updateLiveEditTimer;
 
-    Presets m_presets;
-    QString m_filePath = "Presets.json";
+    std::unique_ptr<StartupEntry> m_startupEntry;
+
+    OverlayWindow m_overlay;
+    IconCache m_icons;
+
+    TrayIconRenderer m_trayRenderer;
+    QElapsedTimer m_trayUpdateTimer;
+
+    PresetEngine m_engine;
+    Presets& m_presets;
+
+    ControlServer m_controlServer;
+    MetricsServer m_metricsServer;
+
+#ifdef REDMIOSD_DBUS
+    PowerProfilesService m_powerProfilesService;
+#endif
 };
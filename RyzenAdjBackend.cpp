@@ -0,0 +1,105 @@
+#include "RyzenAdjBackend.h"
+
+#include <QMap>
+
+#include <cmath>
+#include <functional>
+
+#include <ryzenadj.h>
+
+QMap<QString, std::function<int(ryzen_access, int32_t)>> g_ryzenMapper
+{
+    { "stapm-limit", &set_stapm_limit },
+    { "fast-limit", &set_fast_limit },
+    { "slow-limit", &set_slow_limit },
+    { "slow-time", &set_slow_time },
+    { "stapm-time", &set_stapm_time },
+    { "tctl-temp", &set_tctl_temp },
+    { "vrm-current", &set_vrm_current },
+    { "vrmsoc-current", &set_vrmsoc_current },
+    { "vrmmax-current", &set_vrmmax_current},
+    { "vrmsocmax-current", &set_vrmsocmax_current },
+    { "psi0-current", &set_psi0_current },
+    { "psi0soc-current", &set_psi0soc_current },
+    { "max-socclk-frequency", &set_max_socclk_freq },
+    { "min-socclk-frequency", &set_min_socclk_freq },
+    { "max-fclk-frequency", &set_max_fclk_freq },
+    { "min-fclk-frequency", &set_min_fclk_freq },
+    { "max-vcn", &set_max_vcn },
+    { "min-vcn", &set_min_vcn },
+    { "max-lclk", &set_max_lclk },
+    { "min-lclk", &set_min_lclk },
+    { "max-gfxclk", &set_max_gfxclk_freq },
+    { "min-gfxclk", &set_min_gfxclk_freq },
+    { "prochot-deassertion-ramp", &set_prochot_deassertion_ramp },
+    { "apu-skin-temp", &set_apu_skin_temp_limit },
+    { "dgpu-skin-temp", &set_dgpu_skin_temp_limit },
+    { "apu-slow-limit", &set_apu_slow_limit },
+    { "skin-temp-limit", &set_skin_temp_power_limit },
+};
+
+RyzenAdjBackend::RyzenAdjBackend()
+{
+}
+
+RyzenAdjBackend::~RyzenAdjBackend()
+{
+    if (m_ryzen != nullptr)
+        cleanup_ryzenadj(m_ryzen);
+}
+
+bool RyzenAdjBackend::init()
+{
+    if (m_ryzen == nullptr)
+        m_ryzen = init_ryzenadj();
+
+    return m_ryzen != nullptr;
+}
+
+bool RyzenAdjBackend::isReady() const
+{
+    return m_ryzen != nullptr;
+}
+
+bool RyzenAdjBackend::hasArg(const QString& name) const
+{
+    return g_ryzenMapper.contains(name);
+}
+
+int32_t RyzenAdjBackend::applyArg(const QString& name, int32_t value)
+{
+    auto it = g_ryzenMapper.constFind(name);
+    if (it == g_ryzenMapper.constEnd())
+        return ADJ_ERR_FAM_UNSUPPORTED;
+
+    return it.value()(m_ryzen, value);
+}
+
+void RyzenAdjBackend::refreshTable()
+{
+    refresh_table(m_ryzen);
+}
+
+void RyzenAdjBackend::readTelemetry(Telemetry& telemetry)
+{
+    telemetry.socketPower = get_socket_power(m_ryzen);
+    telemetry.tctlTemp = get_tctl_temp_value(m_ryzen);
+    telemetry.stapmValue = get_stapm_value(m_ryzen);
+    telemetry.stapmLimit = get_stapm_limit(m_ryzen);
+    telemetry.fastValue = get_fast_value(m_ryzen);
+    telemetry.fastLimit = get_fast_limit(m_ryzen);
+    telemetry.slowValue = get_slow_value(m_ryzen);
+    telemetry.slowLimit = get_slow_limit(m_ryzen);
+
+    // ryzenadj returns NaN past the cores of the PM table version, count them once
+    if (m_coreCount < 0)
+    {
+        m_coreCount = 0;
+        while (m_coreCount < g_maxCores && std::isfinite(get_core_clk(m_ryzen, m_coreCount)))
+            ++m_coreCount;
+    }
+
+    telemetry.coreCount = m_coreCount;
+    for (int32_t i = 0; i < telemetry.coreCount; ++i)
+        telemetry.coreClocks[i] = get_core_clk(m_ryzen, i);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "SmuBackend.h"
+
+struct _ryzen_access;
+
+// SMU access through the ryzenadj library
+class RyzenAdjBackend : public SmuBackend
+{
+public:
+    RyzenAdjBackend();
+    virtual ~RyzenAdjBackend();
+
+    bool init() override;
+    bool isReady() const override;
+
+    bool hasArg(const QString& name) const override;
+    int32_t applyArg(const QString& name, int32_t value) override;
+
+    void refreshTable() override;
+    void readTelemetry(Telemetry& telemetry) override;
+
+private:
+    _ryzen_access* m_ryzen = nullptr;
+    int32_t m_coreCount = -1;
+};
@@ -0,0 +1,236 @@
+#include "RyzenSmuBackend.h"
+
+#include <QDebug>
+#include <QThread>
+
+#include <chrono>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+// The PM table starts with the STAPM, fast and slow limit/value pairs on every
+// version, everything after that moves between versions
+constexpr int32_t g_stapmLimitOffset = 0x00;
+constexpr int32_t g_stapmValueOffset = 0x04;
+constexpr int32_t g_fastLimitOffset = 0x08;
+constexpr int32_t g_fastValueOffset = 0x0C;
+constexpr int32_t g_slowLimitOffset = 0x10;
+constexpr int32_t g_slowValueOffset = 0x14;
+
+// How long the mailbox may take before the command counts as timed out
+constexpr int64_t g_commandTimeout = 100000000;
+
+// The MP1 message ids ryzenadj uses for these limits on Renoir and later.
+// RSMU numbers its messages differently, so they only go to mp1_smu_cmd.
+const QHash<QString, uint32_t>& RyzenSmuBackend::commands()
+{
+    static const QHash<QString, uint32_t> commands
+    {
+        { "stapm-limit", 0x14 },
+        { "fast-limit", 0x15 },
+        { "slow-limit", 0x16 },
+        { "slow-time", 0x17 },
+        { "stapm-time", 0x18 },
+        { "tctl-temp", 0x19 },
+        { "vrm-current", 0x1A },
+        { "vrmsoc-current", 0x1B },
+        { "vrmmax-current", 0x1C },
+        { "vrmsocmax-current", 0x1D },
+    };
+
+    return commands;
+}
+
+RyzenSmuBackend::RyzenSmuBackend(const QString& rootPath, int32_t tctlOffset, int32_t socketPowerOffset)
+    : m_rootPath(rootPath.toLocal8Bit())
+    , m_tctlOffset(tctlOffset)
+    , m_socketPowerOffset(socketPowerOffset)
+{
+}
+
+RyzenSmuBackend::~RyzenSmuBackend()
+{
+    close();
+}
+
+bool RyzenSmuBackend::init()
+{
+#ifdef Q_OS_LINUX
+    if (isReady())
+        return true;
+
+    m_argsFd = openFile("smu_args", O_RDWR);
+    // Not rsmu_cmd, the ids of commands() are MP1 messages
+    m_commandFd = openFile("mp1_smu_cmd", O_RDWR);
+    m_tableFd = openFile("pm_table", O_RDONLY);
+
+    if (m_argsFd < 0 || m_commandFd < 0)
+    {
+        qDebug() << "Failed to open the ryzen_smu mailbox in" << m_rootPath << strerror(errno);
+        close();
+        return false;
+    }
+
+    // The table is optional, limits can be set without it
+    if (m_tableFd >= 0)
+    {
+        uint64_t size = 0;
+
+        int sizeFd = openFile("pm_table_size", O_RDONLY);
+        if (sizeFd >= 0)
+        {
+            if (::pread(sizeFd, &size, sizeof(size), 0) <= 0)
+                size = 0;
+
+            ::close(sizeFd);
+        }
+
+        m_table.assign(size > 0 && size <= 0x10000 ? size : 0x1000, 0);
+    }
+    else
+    {
+        qDebug() << "The ryzen_smu PM table is not available, telemetry stays empty.";
+    }
+
+    qDebug() << "ryzen_smu backend ready at" << m_rootPath;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool RyzenSmuBackend::isReady() const
+{
+    return m_commandFd >= 0;
+}
+
+bool RyzenSmuBackend::hasArg(const QString& name) const
+{
+    return commands().contains(name);
+}
+
+int32_t RyzenSmuBackend::applyArg(const QString& name, int32_t value)
+{
+    auto it = commands().constFind(name);
+    if (it == commands().constEnd())
+        return g_smuErrorUnsupported;
+
+    return sendCommand(it.value(), static_cast<uint32_t>(value));
+}
+
+void RyzenSmuBackend::refreshTable()
+{
+#ifdef Q_OS_LINUX
+    if (m_tableFd < 0) return;
+
+    ssize_t length = ::pread(m_tableFd, m_table.data(), m_table.size(), 0);
+    m_tableLength = length > 0 ? static_cast<size_t>(length) : 0;
+#endif
+}
+
+void RyzenSmuBackend::readTelemetry(Telemetry& telemetry)
+{
+    telemetry.stapmLimit = tableValue(g_stapmLimitOffset);
+    telemetry.stapmValue = tableValue(g_stapmValueOffset);
+    telemetry.fastLimit = tableValue(g_fastLimitOffset);
+    telemetry.fastValue = tableValue(g_fastValueOffset);
+    telemetry.slowLimit = tableValue(g_slowLimitOffset);
+    telemetry.slowValue = tableValue(g_slowValueOffset);
+    telemetry.tctlTemp = tableValue(m_tctlOffset);
+    telemetry.socketPower = tableValue(m_socketPowerOffset);
+
+    // Core clocks have no fixed place in the table
+    telemetry.coreCount = 0;
+}
+
+int RyzenSmuBackend::openFile(const char* name, int flags) const
+{
+#ifdef Q_OS_LINUX
+    QByteArray filePath = m_rootPath + '/' + name;
+    return ::open(filePath.constData(), flags | O_CLOEXEC);
+#else
+    Q_UNUSED(name);
+    Q_UNUSED(flags);
+    return -1;
+#endif
+}
+
+int32_t RyzenSmuBackend::sendCommand(uint32_t command, uint32_t value)
+{
+#ifdef Q_OS_LINUX
+    if (!isReady()) return g_smuErrorAccess;
+
+    const uint32_t args[6] = { value, 0, 0, 0, 0, 0 };
+
+    if (::pwrite(m_argsFd, args, sizeof(args), 0) != sizeof(args))
+        return g_smuErrorAccess;
+
+    if (::pwrite(m_commandFd, &command, sizeof(command), 0) != sizeof(command))
+        return errno == EBUSY || errno == ETIMEDOUT ? g_smuErrorTimeout : g_smuErrorAccess;
+
+    // The driver answers within the write, a mailbox that has not answered
+    // yet still reads back the command id
+    auto start = std::chrono::steady_clock::now();
+
+    uint32_t status = command;
+    while (true)
+    {
+        if (::pread(m_commandFd, &status, sizeof(status), 0) != sizeof(status))
+            return g_smuErrorAccess;
+
+        if (status != command)
+            break;
+
+        if (std::chrono::steady_clock::now() - start > std::chrono::nanoseconds(g_commandTimeout))
+            return g_smuErrorTimeout;
+
+        QThread::yieldCurrentThread();
+    }
+
+    switch (status)
+    {
+        case StatusOk:
+            return 0;
+        case StatusUnknownCommand:
+            return g_smuErrorUnsupported;
+        case StatusRejectedPrerequisite:
+        case StatusRejectedBusy:
+        case StatusFailed:
+            return g_smuErrorRejected;
+        default:
+            return g_smuErrorAccess;
+    }
+#else
+    Q_UNUSED(command);
+    Q_UNUSED(value);
+    return g_smuErrorFamily;
+#endif
+}
+
+float RyzenSmuBackend::tableValue(int32_t offset) const
+{
+    if (offset < 0 || static_cast<size_t>(offset) + sizeof(float) > m_tableLength)
+        return 0.0f;
+
+    float value;
+    std::memcpy(&value, m_table.data() + offset, sizeof(value));
+    return value;
+}
+
+void RyzenSmuBackend::close()
+{
+#ifdef Q_OS_LINUX
+    for (int* fd : { &m_argsFd, &m_commandFd, &m_tableFd })
+    {
+        if (*fd >= 0)
+            ::close(*fd);
+
+        *fd = -1;
+    }
+#endif
+}
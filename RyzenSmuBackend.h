@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+
+#include <vector>
+
+#include "SmuBackend.h"
+
+// SMU access through the sysfs files of the ryzen_smu kernel module. The files
+// stay open, a command is a pwrite of the args and one of the command id, then
+// the status is read back from the command file until the mailbox answers. The
+// PM table is pread into a buffer allocated once. Any directory with the same
+// files works as root, so a fake mailbox can stand in for the driver.
+class RyzenSmuBackend : public SmuBackend
+{
+public:
+    // Mailbox status codes, as ryzen_smu reports them
+    static constexpr uint32_t StatusOk = 0x01;
+    static constexpr uint32_t StatusFailed = 0xFF;
+    static constexpr uint32_t StatusUnknownCommand = 0xFE;
+    static constexpr uint32_t StatusRejectedPrerequisite = 0xFD;
+    static constexpr uint32_t StatusRejectedBusy = 0xFC;
+
+    // MP1 message ids of the limits, the same on Renoir and newer mobile APUs
+    static const QHash<QString, uint32_t>& commands();
+
+    RyzenSmuBackend(const QString& rootPath, int32_t tctlOffset = -1, int32_t socketPowerOffset = -1);
+    virtual ~RyzenSmuBackend();
+
+    bool init() override;
+    bool isReady() const override;
+
+    bool hasArg(const QString& name) const override;
+    int32_t applyArg(const QString& name, int32_t value) override;
+
+    void refreshTable() override;
+    void readTelemetry(Telemetry& telemetry) override;
+
+private:
+    int openFile(const char* name, int flags) const;
+    int32_t sendCommand(uint32_t command, uint32_t value);
+    float tableValue(int32_t offset) const;
+    void close();
+
+    QByteArray m_rootPath;
+    int32_t m_tctlOffset;
+    int32_t m_socketPowerOffset;
+
+    int m_argsFd = -1;
+    int m_commandFd = -1;
+    int m_tableFd = -1;
+
+    std::vector<char> m_table;
+    size_t m_tableLength = 0;
+};
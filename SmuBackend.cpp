@@ -0,0 +1,60 @@
+#include "SmuBackend.h"
+
+#include <QDebug>
+
+#ifdef REDMIOSD_RYZENADJ
+#include "RyzenAdjBackend.h"
+#endif
+
+#include "RyzenSmuBackend.h"
+
+QStringList SmuBackend::argNames()
+{
+    return QStringList
+    {
+        "apu-skin-temp",
+        "apu-slow-limit",
+        "dgpu-skin-temp",
+        "fast-limit",
+        "max-fclk-frequency",
+        "max-gfxclk",
+        "max-lclk",
+        "max-socclk-frequency",
+        "max-vcn",
+        "min-fclk-frequency",
+        "min-gfxclk",
+        "min-lclk",
+        "min-socclk-frequency",
+        "min-vcn",
+        "prochot-deassertion-ramp",
+        "psi0-current",
+        "psi0soc-current",
+        "skin-temp-limit",
+        "slow-limit",
+        "slow-time",
+        "stapm-limit",
+        "stapm-time",
+        "tctl-temp",
+        "vrm-current",
+        "vrmmax-current",
+        "vrmsoc-current",
+        "vrmsocmax-current",
+    };
+}
+
+std::unique_ptr<SmuBackend> createSmuBackend(const SmuSettings& settings)
+{
+#ifdef Q_OS_LINUX
+    if (settings.backend == "ryzen_smu")
+        return std::make_unique<RyzenSmuBackend>(settings.rootPath, settings.tctlOffset, settings.socketPowerOffset);
+#endif
+
+    if (settings.backend != "ryzenadj")
+        qDebug() << "Unknown SMU backend:" << settings.backend << "falling back to ryzenadj.";
+
+#ifdef REDMIOSD_RYZENADJ
+    return std::make_unique<RyzenAdjBackend>();
+#else
+    return nullptr;
+#endif
+}
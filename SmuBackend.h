@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+
+#include "Telemetry.h"
+
+// ryzenadj's ADJ_ERR_* codes, every backend reports failures with them
+constexpr int32_t g_smuErrorFamily = -1;
+constexpr int32_t g_smuErrorTimeout = -2;
+constexpr int32_t g_smuErrorUnsupported = -3;
+constexpr int32_t g_smuErrorRejected = -4;
+constexpr int32_t g_smuErrorAccess = -5;
+
+struct SmuSettings
+{
+    QString backend = "ryzenadj";
+    QString rootPath = "/sys/kernel/ryzen_smu_drv";
+    int32_t tctlOffset = -1;
+    int32_t socketPowerOffset = -1;
+};
+
+// Everything the preset engine needs from the SMU. Results of applyArg follow
+// ryzenadj, negative values are ADJ_ERR_* codes.
+class SmuBackend
+{
+public:
+    virtual ~SmuBackend() = default;
+
+    // Arg names presets may use, backends support all or a subset of them
+    static QStringList argNames();
+
+    virtual bool init() = 0;
+    virtual bool isReady() const = 0;
+
+    virtual bool hasArg(const QString& name) const = 0;
+    virtual int32_t applyArg(const QString& name, int32_t value) = 0;
+
+    virtual void refreshTable() = 0;
+    virtual void readTelemetry(Telemetry& telemetry) = 0;
+};
+
+// The backend picked by the settings, nullptr when this build has none
+std::unique_ptr<SmuBackend> createSmuBackend(const SmuSettings& settings);
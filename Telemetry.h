@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+
+constexpr int32_t g_maxCores = 16;
+
+// Latest PM table sample, refreshed on every watchdog tick
+struct Telemetry
+{
+    int64_t timestamp = 0;
+    float socketPower = 0.0f;
+    float tctlTemp = 0.0f;
+    float stapmValue = 0.0f;
+    float stapmLimit = 0.0f;
+    float fastValue = 0.0f;
+    float fastLimit = 0.0f;
+    float slowValue = 0.0f;
+    float slowLimit = 0.0f;
+    int32_t coreCount = 0;
+    float coreClocks[g_maxCores] = {};
+};
+
+// Internal counters of the preset engine, fixed size so they never allocate
+struct EngineStats
+{
+    // Upper bounds of the apply latency histogram in ms, the last bucket is +Inf
+    static constexpr double LatencyBounds[] = { 0.1, 0.5, 1.0, 2.5, 5.0, 10.0, 25.0, 50.0, 100.0, 250.0 };
+    static constexpr int32_t LatencyBuckets = std::size(LatencyBounds) + 1;
+
+    // ADJ_ERR_* codes -1 to -5, the last slot counts any other negative result
+    static constexpr int32_t ErrorCodes = 6;
+
+    uint64_t applyCount = 0;
+    double applyLatencySum = 0.0;
+    uint64_t applyLatency[LatencyBuckets] = {};
+    uint64_t smuErrors[ErrorCodes] = {};
+    uint64_t driftEvents = 0;
+    uint64_t watchdogWakeups = 0;
+
+    void recordApply(double latency)
+    {
+        int32_t bucket = 0;
+        while (bucket < LatencyBuckets - 1 && latency > LatencyBounds[bucket])
+            ++bucket;
+
+        ++applyCount;
+        ++applyLatency[bucket];
+        applyLatencySum += latency;
+    }
+
+    void recordError(int32_t code)
+    {
+        int32_t index = -code - 1;
+        ++smuErrors[index >= 0 && index < ErrorCodes - 1 ? index : ErrorCodes - 1];
+    }
+};
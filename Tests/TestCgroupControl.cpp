@@ -0,0 +1,119 @@
+#include <QFile>
+#include <QTest>
+
+#include <memory>
+
+#include "CgroupControl.h"
+#include "TestDirectory.h"
+
+// A cgroup v2 tree in a temporary directory
+class TestCgroupControl : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void applyAndRestore();
+    void reloadRestoresDropped();
+    void rollback();
+
+private:
+    bool writeCgroup(const QString& cgroup, const QByteArray& cpus, const QByteArray& max);
+
+    std::unique_ptr<TestDirectory> m_directory;
+};
+
+void TestCgroupControl::init()
+{
+    m_directory = std::make_unique<TestDirectory>();
+    QVERIFY(m_directory->isValid());
+
+    QVERIFY(writeCgroup("background.slice", "0-7", "max 100000"));
+    QVERIFY(writeCgroup("app.slice", "0-7", "max 100000"));
+}
+
+void TestCgroupControl::applyAndRestore()
+{
+#ifdef Q_OS_LINUX
+    CgroupControl control;
+    control.open(m_directory->path(), { "background.slice", "app.slice" });
+    QVERIFY(control.isOpen());
+
+    QVERIFY(control.apply({ { "background.slice", { "0-3", "5000 10000" } } }));
+
+    QCOMPARE(m_directory->readFile("background.slice/cpuset.cpus"), QByteArray("0-3"));
+    QCOMPARE(m_directory->readFile("background.slice/cpu.max"), QByteArray("5000 10000"));
+    QCOMPARE(m_directory->readFile("app.slice/cpuset.cpus"), QByteArray("0-7"));
+
+    // A preset without the cgroup gives it back
+    QVERIFY(control.apply({}));
+
+    QCOMPARE(m_directory->readFile("background.slice/cpuset.cpus"), QByteArray("0-7"));
+    QCOMPARE(m_directory->readFile("background.slice/cpu.max"), QByteArray("max 100000"));
+
+    QVERIFY(control.apply({ { "app.slice", { "4-7", QString() } } }));
+    control.close();
+
+    QVERIFY(!control.isOpen());
+    QCOMPARE(m_directory->readFile("app.slice/cpuset.cpus"), QByteArray("0-7"));
+#else
+    QSKIP("cgroups are Linux only");
+#endif
+}
+
+void TestCgroupControl::reloadRestoresDropped()
+{
+#ifdef Q_OS_LINUX
+    CgroupControl control;
+    control.open(m_directory->path(), { "background.slice", "app.slice" });
+
+    QVERIFY(control.apply({ { "background.slice", { "0-3", QString() } }, { "app.slice", { "4-7", QString() } } }));
+
+    // Presets.json no longer names background.slice
+    control.open(m_directory->path(), { "app.slice" });
+
+    QCOMPARE(m_directory->readFile("background.slice/cpuset.cpus"), QByteArray("0-7"));
+    QCOMPARE(m_directory->readFile("app.slice/cpuset.cpus"), QByteArray("4-7"));
+
+    // Not open anymore, so not written either
+    QVERIFY(control.apply({ { "background.slice", { "0-1", QString() } } }));
+
+    QCOMPARE(m_directory->readFile("background.slice/cpuset.cpus"), QByteArray("0-7"));
+    QCOMPARE(m_directory->readFile("app.slice/cpuset.cpus"), QByteArray("0-7"));
+#else
+    QSKIP("cgroups are Linux only");
+#endif
+}
+
+void TestCgroupControl::rollback()
+{
+#ifdef Q_OS_LINUX
+    // Every write to /dev/full fails with ENOSPC
+    if (!QFile::exists("/dev/full"))
+        QSKIP("No /dev/full to fail a write");
+
+    QVERIFY(QFile::remove(m_directory->filePath("app.slice/cpu.max")));
+    QVERIFY(QFile::link("/dev/full", m_directory->filePath("app.slice/cpu.max")));
+
+    CgroupControl control;
+    control.open(m_directory->path(), { "background.slice", "app.slice" });
+
+    QVERIFY(!control.apply({ { "background.slice", { "0-3", "5000 10000" } }, { "app.slice", { "4-7", "5000 10000" } } }));
+
+    QCOMPARE(m_directory->readFile("background.slice/cpuset.cpus"), QByteArray("0-7"));
+    QCOMPARE(m_directory->readFile("background.slice/cpu.max"), QByteArray("max 100000"));
+    QCOMPARE(m_directory->readFile("app.slice/cpuset.cpus"), QByteArray("0-7"));
+#else
+    QSKIP("cgroups are Linux only");
+#endif
+}
+
+bool TestCgroupControl::writeCgroup(const QString& cgroup, const QByteArray& cpus, const QByteArray& max)
+{
+    return m_directory->writeFile(cgroup + "/cpuset.cpus", cpus) && m_directory->writeFile(cgroup + "/cpu.max", max);
+}
+
+QTEST_GUILESS_MAIN(TestCgroupControl)
+
+#include "TestCgroupControl.moc"
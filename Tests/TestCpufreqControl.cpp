@@ -0,0 +1,178 @@
+#include <QTest>
+
+#include <memory>
+
+#include "CpufreqControl.h"
+#include "TestDirectory.h"
+
+// cpufreq policies in a temporary directory
+class TestCpufreqControl : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void parseEpp();
+    void apply();
+    void unavailableEpp();
+    void refresh();
+    void parallelApply();
+
+private:
+    bool writePolicies(int32_t count, const QByteArray& availablePreferences);
+    QByteArray readFile(int32_t policy, const char* name) const;
+
+    std::unique_ptr<TestDirectory> m_directory;
+};
+
+void TestCpufreqControl::init()
+{
+    m_directory = std::make_unique<TestDirectory>();
+    QVERIFY(m_directory->isValid());
+}
+
+void TestCpufreqControl::parseEpp()
+{
+    QCOMPARE(CpufreqControl::parseEpp("default"), 0);
+    QCOMPARE(CpufreqControl::parseEpp("balance_power"), 3);
+    QCOMPARE(CpufreqControl::parseEpp("2"), 2);
+
+    // Anything else must not turn into 0, which is "default"
+    QCOMPARE(CpufreqControl::parseEpp("turbo"), -1);
+    QCOMPARE(CpufreqControl::parseEpp("9"), -1);
+    QCOMPARE(CpufreqControl::parseEpp(""), -1);
+}
+
+void TestCpufreqControl::apply()
+{
+#ifdef Q_OS_LINUX
+    QVERIFY(writePolicies(2, "default performance balance_performance balance_power power"));
+
+    CpufreqControl control;
+    QVERIFY(control.open(m_directory->path()));
+    QCOMPARE(control.policyCount(), 2);
+
+    QMap<QString, int32_t> args
+    {
+        { "epp", CpufreqControl::parseEpp("performance") },
+        { "scaling-min-freq", 800000 },
+        { "scaling-max-freq", 2000000 },
+        { "stapm-limit", 15000 },
+    };
+
+    QCOMPARE(control.apply(args), 0);
+
+    for (int32_t policy = 0; policy < 2; ++policy)
+    {
+        QCOMPARE(readFile(policy, "energy_performance_preference"), QByteArray("performance"));
+        QCOMPARE(readFile(policy, "scaling_min_freq"), QByteArray("800000"));
+        QCOMPARE(readFile(policy, "scaling_max_freq"), QByteArray("2000000"));
+    }
+#else
+    QSKIP("cpufreq is Linux only");
+#endif
+}
+
+void TestCpufreqControl::unavailableEpp()
+{
+#ifdef Q_OS_LINUX
+    QVERIFY(writePolicies(1, "default performance balance_performance"));
+    QVERIFY(m_directory->writeFile("policy0/energy_performance_preference", "performance"));
+
+    CpufreqControl control;
+    QVERIFY(control.open(m_directory->path()));
+
+    // "power" is not offered, it is skipped before it reaches the driver and
+    // the other args still go through
+    QCOMPARE(control.apply({ { "epp", CpufreqControl::parseEpp("power") }, { "scaling-max-freq", 2000000 } }), 0);
+
+    QCOMPARE(readFile(0, "energy_performance_preference"), QByteArray("performance"));
+    QCOMPARE(readFile(0, "scaling_max_freq"), QByteArray("2000000"));
+
+    QCOMPARE(control.apply({ { "epp", CpufreqControl::parseEpp("balance_performance") } }), 0);
+    QCOMPARE(readFile(0, "energy_performance_preference"), QByteArray("balance_performance"));
+
+    // Out of range, not even a name to check against the list
+    QCOMPARE(control.apply({ { "epp", 7 } }), 0);
+    QCOMPARE(readFile(0, "energy_performance_preference"), QByteArray("balance_performance"));
+#else
+    QSKIP("cpufreq is Linux only");
+#endif
+}
+
+void TestCpufreqControl::refresh()
+{
+#ifdef Q_OS_LINUX
+    QVERIFY(writePolicies(1, QByteArray()));
+
+    CpufreqControl control;
+    QVERIFY(control.open(m_directory->path()));
+
+    QCOMPARE(control.apply({ { "scaling-max-freq", 2000000 } }), 0);
+
+    // Another tool puts the old value back, the cache still has the new one
+    QVERIFY(m_directory->writeFile("policy0/scaling_max_freq", "3000000"));
+
+    QCOMPARE(control.apply({ { "scaling-max-freq", 2000000 } }), 0);
+    QCOMPARE(readFile(0, "scaling_max_freq"), QByteArray("3000000"));
+
+    control.refresh();
+
+    QCOMPARE(control.apply({ { "scaling-max-freq", 2000000 } }), 0);
+    QCOMPARE(readFile(0, "scaling_max_freq"), QByteArray("2000000"));
+#else
+    QSKIP("cpufreq is Linux only");
+#endif
+}
+
+void TestCpufreqControl::parallelApply()
+{
+#ifdef Q_OS_LINUX
+    QVERIFY(writePolicies(16, QByteArray()));
+
+    CpufreqControl control;
+    QVERIFY(control.open(m_directory->path()));
+
+    // Far more writes than the calling thread takes alone
+    QCOMPARE(control.apply({ { "epp", CpufreqControl::parseEpp("performance") }, { "scaling-max-freq", 2000000 }, { "boost", 0 } }), 0);
+
+    for (int32_t policy = 0; policy < 16; ++policy)
+    {
+        QCOMPARE(readFile(policy, "energy_performance_preference"), QByteArray("performance"));
+        QCOMPARE(readFile(policy, "scaling_max_freq"), QByteArray("2000000"));
+        QCOMPARE(readFile(policy, "boost"), QByteArray("0"));
+    }
+#else
+    QSKIP("cpufreq is Linux only");
+#endif
+}
+
+bool TestCpufreqControl::writePolicies(int32_t count, const QByteArray& availablePreferences)
+{
+    for (int32_t i = 0; i < count; ++i)
+    {
+        const QString policy = QString("policy%1/").arg(i);
+
+        if (!m_directory->writeFile(policy + "energy_performance_preference", "power")
+            || !m_directory->writeFile(policy + "scaling_min_freq", "400000")
+            || !m_directory->writeFile(policy + "scaling_max_freq", "3000000")
+            || !m_directory->writeFile(policy + "boost", "1"))
+            return false;
+
+        // Without the list nothing is filtered, like on drivers that have none
+        if (!availablePreferences.isEmpty() && !m_directory->writeFile(policy + "energy_performance_available_preferences", availablePreferences))
+            return false;
+    }
+
+    return true;
+}
+
+QByteArray TestCpufreqControl::readFile(int32_t policy, const char* name) const
+{
+    return m_directory->readFile(QString("policy%1/%2").arg(policy).arg(QLatin1String(name)));
+}
+
+QTEST_GUILESS_MAIN(TestCpufreqControl)
+
+#include "TestCpufreqControl.moc"
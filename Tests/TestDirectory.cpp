@@ -0,0 +1,67 @@
+#include "TestDirectory.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+
+TestDirectory::TestDirectory()
+{
+}
+
+TestDirectory::~TestDirectory()
+{
+}
+
+bool TestDirectory::isValid() const
+{
+    return m_directory.isValid();
+}
+
+QString TestDirectory::path() const
+{
+    return m_directory.path();
+}
+
+QString TestDirectory::filePath(const QString& name) const
+{
+    return m_directory.filePath(name);
+}
+
+bool TestDirectory::writeFile(const QString& name, const QByteArray& value)
+{
+    const QString path = filePath(name);
+    if (!QDir().mkpath(QFileInfo(path).path()))
+        return false;
+
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(value + "\n") == value.size() + 1;
+}
+
+QByteArray TestDirectory::readFile(const QString& name) const
+{
+    QFile file(filePath(name));
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    return file.readAll().trimmed();
+}
+
+QString TestDirectory::writePresets(const QJsonObject& overrides)
+{
+    QFile source(REDMIOSD_PRESETS_PATH);
+    if (!source.open(QIODevice::ReadOnly))
+        return QString();
+
+    QJsonObject rootObject = QJsonDocument::fromJson(source.readAll()).object();
+    for (auto it = overrides.constBegin(); it != overrides.constEnd(); ++it)
+        rootObject[it.key()] = it.value();
+
+    const QString presetsPath = filePath("Presets.json");
+
+    QFile file(presetsPath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(rootObject).toJson()) < 0)
+        return QString();
+
+    return presetsPath;
+}
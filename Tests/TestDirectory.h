@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+#include <QTemporaryDir>
+
+// A temporary directory standing in for a sysfs tree. Files are written with
+// a trailing newline, the way the kernel shows attributes, and read back
+// trimmed. The classes under test rewrite files in place with pwrite, which
+// sysfs takes as the whole value, but a regular file keeps the tail of a
+// longer old value. A value written over a seeded one has to be at least as
+// long.
+class TestDirectory
+{
+public:
+    TestDirectory();
+    ~TestDirectory();
+
+    bool isValid() const;
+    QString path() const;
+    QString filePath(const QString& name) const;
+
+    // Creates the directories leading to name as well
+    bool writeFile(const QString& name, const QByteArray& value);
+    QByteArray readFile(const QString& name) const;
+
+    // A copy of the Presets.json of the repo, top level keys of overrides
+    // replace those of the file. Returns the path of the copy, empty on failure.
+    QString writePresets(const QJsonObject& overrides = QJsonObject());
+
+private:
+    QTemporaryDir m_directory;
+};
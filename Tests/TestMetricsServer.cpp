@@ -0,0 +1,148 @@
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTcpSocket>
+#include <QTest>
+
+#include "MetricsServer.h"
+#include "PresetEngine.h"
+#include "TestDirectory.h"
+
+// Scrapes over a real socket, the server renders from the engine signals
+class TestMetricsServer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void scrape();
+    void escapedLabels();
+    void notFound();
+    void stop();
+
+private:
+    static QByteArray request(quint16 port, const QByteArray& path);
+};
+
+void TestMetricsServer::scrape()
+{
+    TestDirectory directory;
+    const QString presetsPath = directory.writePresets();
+    QVERIFY(!presetsPath.isEmpty());
+
+    PresetEngine engine(presetsPath);
+    engine.readPresets();
+
+    MetricsServer server(engine);
+    QVERIFY(server.listen(0));
+
+    engine.switchPreset("silence");
+
+    const QByteArray response = request(server.serverPort(), "/metrics");
+
+    QVERIFY(response.startsWith("HTTP/1.1 200 OK\r\n"));
+    QVERIFY(response.contains("Content-Type: text/plain; version=0.0.4\r\n"));
+
+    // Content-Length has to match what follows the header
+    const qsizetype headerEnd = response.indexOf("\r\n\r\n");
+    QVERIFY(headerEnd > 0);
+    QVERIFY(response.contains("Content-Length: " + QByteArray::number(response.size() - headerEnd - 4) + "\r\n"));
+
+    QVERIFY(response.contains("redmiosd_active_preset{preset=\"silence\"} 1\n"));
+    QVERIFY(response.contains("redmiosd_active_preset{preset=\"turbo\"} 0\n"));
+
+    engine.switchPreset("turbo");
+
+    QVERIFY(request(server.serverPort(), "/metrics").contains("redmiosd_active_preset{preset=\"turbo\"} 1\n"));
+}
+
+void TestMetricsServer::escapedLabels()
+{
+    const QString longName(300, QChar('x'));
+
+    QJsonArray presetsArray;
+    for (const QString& name : { QString("say \"hi\""), QString("back\\slash\nnewline"), QString::fromUtf8("r\xc3\xa9" "duit"), longName })
+        presetsArray.append(QJsonObject{ { "name", name }, { "args", QJsonObject{ { "stapm-limit", 15000 } } } });
+
+    TestDirectory directory;
+    const QString presetsPath = directory.writePresets({ { "presets", presetsArray }, { "defaultPreset", longName }, { "lastPreset", longName } });
+    QVERIFY(!presetsPath.isEmpty());
+
+    PresetEngine engine(presetsPath);
+    engine.readPresets();
+
+    MetricsServer server(engine);
+    QVERIFY(server.listen(0));
+
+    engine.switchPreset(longName);
+
+    const QByteArray response = request(server.serverPort(), "/metrics");
+
+    QVERIFY(response.contains("redmiosd_active_preset{preset=\"say \\\"hi\\\"\"} 0\n"));
+    QVERIFY(response.contains("redmiosd_active_preset{preset=\"back\\\\slash\\nnewline\"} 0\n"));
+    QVERIFY(response.contains("redmiosd_active_preset{preset=\"r\xc3\xa9" "duit\"} 0\n"));
+
+    // Longer than a line of the render buffer, still whole
+    QVERIFY(response.contains("redmiosd_active_preset{preset=\"" + longName.toUtf8() + "\"} 1\n"));
+}
+
+void TestMetricsServer::notFound()
+{
+    TestDirectory directory;
+    const QString presetsPath = directory.writePresets();
+    QVERIFY(!presetsPath.isEmpty());
+
+    PresetEngine engine(presetsPath);
+    engine.readPresets();
+
+    MetricsServer server(engine);
+    QVERIFY(server.listen(0));
+
+    QVERIFY(request(server.serverPort(), "/other").startsWith("HTTP/1.1 404 Not Found\r\n"));
+}
+
+void TestMetricsServer::stop()
+{
+    TestDirectory directory;
+    const QString presetsPath = directory.writePresets();
+    QVERIFY(!presetsPath.isEmpty());
+
+    PresetEngine engine(presetsPath);
+    engine.readPresets();
+
+    MetricsServer server(engine);
+    QVERIFY(server.listen(0));
+
+    const quint16 port = server.serverPort();
+    server.stop();
+
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress::LocalHost, port);
+
+    QVERIFY(!socket.waitForConnected(1000));
+}
+
+QByteArray TestMetricsServer::request(quint16 port, const QByteArray& path)
+{
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress::LocalHost, port);
+
+    if (!socket.waitForConnected(1000))
+        return QByteArray();
+
+    socket.write("GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+
+    // The server answers from this thread, so spin the event loop instead of
+    // blocking in waitForReadyRead(), it closes the connection when done
+    QByteArray response;
+    for (int32_t i = 0; i < 100 && socket.state() != QAbstractSocket::UnconnectedState; ++i)
+    {
+        QTest::qWait(10);
+        response += socket.readAll();
+    }
+
+    return response + socket.readAll();
+}
+
+QTEST_GUILESS_MAIN(TestMetricsServer)
+
+#include "TestMetricsServer.moc"
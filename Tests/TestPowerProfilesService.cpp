@@ -0,0 +1,178 @@
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusMessage>
+#include <QDBusPendingCall>
+#include <QDBusVariant>
+#include <QJsonObject>
+#include <QTest>
+
+#include <memory>
+
+#include "PowerProfilesService.h"
+#include "PresetEngine.h"
+#include "TestDirectory.h"
+
+static const QString g_serviceName = "net.hadess.PowerProfiles";
+static const QString g_objectPath = "/net/hadess/PowerProfiles";
+static const QString g_propertiesInterface = "org.freedesktop.DBus.Properties";
+
+// Round trips through a session bus from a second connection, the way a
+// desktop shell talks to power-profiles-daemon. Skipped without a bus.
+class TestPowerProfilesService : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void properties();
+    void setActiveProfile();
+    void holdProfile();
+    void releaseForeignHold();
+
+private:
+    QDBusMessage call(const QString& interface, const QString& method, const QVariantList& args, const QString& client = "TestPowerProfilesServiceClient");
+    QVariant property(const QString& name);
+
+    std::unique_ptr<TestDirectory> m_directory;
+    std::unique_ptr<PresetEngine> m_engine;
+    std::unique_ptr<PowerProfilesService> m_service;
+};
+
+void TestPowerProfilesService::initTestCase()
+{
+    if (!QDBusConnection::sessionBus().isConnected())
+        QSKIP("No session bus, run the test under dbus-run-session");
+
+    if (QDBusConnection::sessionBus().interface()->isServiceRegistered(g_serviceName).value())
+        QSKIP("net.hadess.PowerProfiles is already taken on the session bus");
+}
+
+void TestPowerProfilesService::init()
+{
+    QJsonObject profilesObject
+    {
+        { "power-saver", "silence" },
+        { "balanced", "silence" },
+        { "performance", "turbo" },
+    };
+
+    QJsonObject powerProfilesObject
+    {
+        { "enabled", true },
+        { "bus", "session" },
+        { "holdPriority", 50 },
+        { "profiles", profilesObject },
+    };
+
+    m_directory = std::make_unique<TestDirectory>();
+    const QString presetsPath = m_directory->writePresets({ { "powerProfiles", powerProfilesObject } });
+    QVERIFY(!presetsPath.isEmpty());
+
+    m_engine = std::make_unique<PresetEngine>(presetsPath);
+    m_engine->readPresets();
+    m_engine->switchPreset("silence");
+
+    m_service = std::make_unique<PowerProfilesService>(*m_engine);
+    QVERIFY(m_service->start());
+}
+
+void TestPowerProfilesService::cleanup()
+{
+    m_service.reset();
+    m_engine.reset();
+    m_directory.reset();
+}
+
+void TestPowerProfilesService::properties()
+{
+    QCOMPARE(property("ActiveProfile").toString(), QString("balanced"));
+    QCOMPARE(property("Version").toString(), QString("0.20"));
+    QCOMPARE(property("PerformanceDegraded").toString(), QString());
+}
+
+void TestPowerProfilesService::setActiveProfile()
+{
+    QDBusMessage reply = call(g_propertiesInterface, "Set", { g_serviceName, "ActiveProfile", QVariant::fromValue(QDBusVariant("performance")) });
+
+    QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+    QCOMPARE(m_engine->activePreset(), QString("turbo"));
+    QCOMPARE(property("ActiveProfile").toString(), QString("performance"));
+
+    reply = call(g_propertiesInterface, "Set", { g_serviceName, "ActiveProfile", QVariant::fromValue(QDBusVariant("turbo")) });
+
+    QCOMPARE(reply.type(), QDBusMessage::ErrorMessage);
+    QCOMPARE(m_engine->activePreset(), QString("turbo"));
+}
+
+void TestPowerProfilesService::holdProfile()
+{
+    call(g_propertiesInterface, "Set", { g_serviceName, "ActiveProfile", QVariant::fromValue(QDBusVariant("performance")) });
+
+    QDBusMessage reply = call(g_serviceName, "HoldProfile", { "power-saver", "Testing", "TestPowerProfilesService" });
+
+    QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+    const uint cookie = reply.arguments().value(0).toUInt();
+    QVERIFY(cookie > 0);
+
+    // A hold goes through the arbiter and wins over the manual choice
+    QCOMPARE(m_engine->activePreset(), QString("silence"));
+
+    reply = call(g_serviceName, "HoldProfile", { "balanced", "Testing", "TestPowerProfilesService" });
+    QCOMPARE(reply.type(), QDBusMessage::ErrorMessage);
+
+    reply = call(g_serviceName, "ReleaseProfile", { cookie });
+
+    QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+    QCOMPARE(m_engine->activePreset(), QString("turbo"));
+
+    reply = call(g_serviceName, "ReleaseProfile", { cookie });
+    QCOMPARE(reply.type(), QDBusMessage::ErrorMessage);
+}
+
+void TestPowerProfilesService::releaseForeignHold()
+{
+    QDBusMessage reply = call(g_serviceName, "HoldProfile", { "performance", "Testing", "TestPowerProfilesService" });
+
+    QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+    const uint cookie = reply.arguments().value(0).toUInt();
+
+    // Another client can't end the hold, its owner can
+    reply = call(g_serviceName, "ReleaseProfile", { cookie }, "TestPowerProfilesServiceOther");
+
+    QCOMPARE(reply.type(), QDBusMessage::ErrorMessage);
+    QCOMPARE(m_engine->activePreset(), QString("turbo"));
+
+    reply = call(g_serviceName, "ReleaseProfile", { cookie });
+
+    QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+    QCOMPARE(m_engine->activePreset(), QString("silence"));
+}
+
+QDBusMessage TestPowerProfilesService::call(const QString& interface, const QString& method, const QVariantList& args, const QString& client)
+{
+    // A connection of its own, like any other client. The service answers
+    // from this thread, so the call is waited for with the event loop running
+    QDBusConnection connection = QDBusConnection::connectToBus(QDBusConnection::SessionBus, client);
+
+    QDBusMessage message = QDBusMessage::createMethodCall(g_serviceName, g_objectPath, interface, method);
+    message.setArguments(args);
+
+    QDBusPendingCall pending = connection.asyncCall(message);
+    for (int32_t i = 0; i < 500 && !pending.isFinished(); ++i)
+        QTest::qWait(10);
+
+    return pending.reply();
+}
+
+QVariant TestPowerProfilesService::property(const QString& name)
+{
+    QDBusMessage reply = call(g_propertiesInterface, "Get", { g_serviceName, name });
+    return reply.arguments().value(0).value<QDBusVariant>().variant();
+}
+
+QTEST_GUILESS_MAIN(TestPowerProfilesService)
+
+#include "TestPowerProfilesService.moc"
@@ -0,0 +1,203 @@
+#include <QByteArrayList>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QSignalSpy>
+#include <QTest>
+
+#include <memory>
+
+#include "PowerSupplyMonitor.h"
+#include "PresetEngine.h"
+#include "TestDirectory.h"
+
+// The rules of Presets.json against a power_supply tree in a temporary
+// directory, state changes come in as injected uevents
+class TestPowerSupplyMonitor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void startState();
+    void unplug();
+    void lowBatteryForced();
+    void capacityReread();
+    void supplyRemoved();
+    void noMainsIsOnline();
+    void unknownSourceRejected();
+
+private:
+    static QByteArray uevent(const QByteArray& action, const QByteArray& name, const QByteArrayList& fields);
+
+    std::unique_ptr<TestDirectory> m_directory;
+    std::unique_ptr<PowerSupplyMonitor> m_monitor;
+};
+
+void TestPowerSupplyMonitor::init()
+{
+    m_directory = std::make_unique<TestDirectory>();
+    QVERIFY(m_directory->isValid());
+
+    QVERIFY(m_directory->writeFile("AC/type", "Mains"));
+    QVERIFY(m_directory->writeFile("AC/online", "1"));
+    QVERIFY(m_directory->writeFile("BAT0/type", "Battery"));
+    QVERIFY(m_directory->writeFile("BAT0/capacity", "50"));
+
+    m_monitor = std::make_unique<PowerSupplyMonitor>();
+    m_monitor->setRules(
+    {
+        { "ac", 101, "turbo", 1, false },
+        { "battery", 101, "silence", 1, false },
+        { "battery", 20, "silence", 100, true },
+    });
+}
+
+void TestPowerSupplyMonitor::startState()
+{
+    QSignalSpy requested(m_monitor.get(), &PowerSupplyMonitor::presetRequested);
+
+    // Without permission for the uevent socket the tree is still read
+    m_monitor->start(m_directory->path());
+
+    QVERIFY(m_monitor->isOnline());
+    QCOMPARE(m_monitor->capacity(), 50);
+    QVERIFY(!m_monitor->isForced());
+
+    QCOMPARE(requested.count(), 1);
+    QCOMPARE(requested.at(0).at(0).toString(), QString("turbo"));
+    QCOMPARE(requested.at(0).at(1).toInt(), 1);
+}
+
+void TestPowerSupplyMonitor::unplug()
+{
+    m_monitor->start(m_directory->path());
+
+    QSignalSpy changed(m_monitor.get(), &PowerSupplyMonitor::stateChanged);
+    QSignalSpy requested(m_monitor.get(), &PowerSupplyMonitor::presetRequested);
+
+    m_monitor->injectUevent(uevent("change", "AC", { "POWER_SUPPLY_TYPE=Mains", "POWER_SUPPLY_ONLINE=0" }));
+
+    QVERIFY(!m_monitor->isOnline());
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(requested.count(), 1);
+    QCOMPARE(requested.at(0).at(0).toString(), QString("silence"));
+
+    // The same state again requests nothing
+    m_monitor->injectUevent(uevent("change", "AC", { "POWER_SUPPLY_ONLINE=0" }));
+
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(requested.count(), 1);
+
+    // Events of other subsystems are ignored
+    m_monitor->injectUevent(QByteArrayList{ "change@/devices/foo", "ACTION=change", "SUBSYSTEM=input", "POWER_SUPPLY_NAME=AC", "POWER_SUPPLY_ONLINE=1" }.join('\0'));
+
+    QVERIFY(!m_monitor->isOnline());
+}
+
+void TestPowerSupplyMonitor::lowBatteryForced()
+{
+    m_monitor->start(m_directory->path());
+    m_monitor->injectUevent(uevent("change", "AC", { "POWER_SUPPLY_ONLINE=0" }));
+
+    QSignalSpy requested(m_monitor.get(), &PowerSupplyMonitor::presetRequested);
+
+    m_monitor->injectUevent(uevent("change", "BAT0", { "POWER_SUPPLY_CAPACITY=15" }));
+
+    QCOMPARE(m_monitor->capacity(), 15);
+    QVERIFY(m_monitor->isForced());
+    QCOMPARE(requested.count(), 1);
+    QCOMPARE(requested.at(0).at(1).toInt(), 100);
+
+    // Back on AC the forced rule no longer matches
+    m_monitor->injectUevent(uevent("change", "AC", { "POWER_SUPPLY_ONLINE=1" }));
+
+    QVERIFY(!m_monitor->isForced());
+    QCOMPARE(requested.count(), 2);
+    QCOMPARE(requested.at(1).at(0).toString(), QString("turbo"));
+}
+
+void TestPowerSupplyMonitor::capacityReread()
+{
+    m_monitor->start(m_directory->path());
+
+    QSignalSpy requested(m_monitor.get(), &PowerSupplyMonitor::presetRequested);
+
+    // The battery drained without an uevent of its own, unplugging reads it
+    QVERIFY(m_directory->writeFile("BAT0/capacity", "15"));
+    m_monitor->injectUevent(uevent("change", "AC", { "POWER_SUPPLY_ONLINE=0" }));
+
+    QCOMPARE(m_monitor->capacity(), 15);
+    QVERIFY(m_monitor->isForced());
+    QCOMPARE(requested.count(), 1);
+    QCOMPARE(requested.at(0).at(1).toInt(), 100);
+
+    // So does a status change of the battery itself
+    QVERIFY(m_directory->writeFile("BAT0/capacity", "12"));
+    m_monitor->injectUevent(uevent("change", "BAT0", { "POWER_SUPPLY_STATUS=Discharging" }));
+
+    QCOMPARE(m_monitor->capacity(), 12);
+}
+
+void TestPowerSupplyMonitor::supplyRemoved()
+{
+    m_monitor->start(m_directory->path());
+
+    QSignalSpy changed(m_monitor.get(), &PowerSupplyMonitor::stateChanged);
+
+    m_monitor->injectUevent(uevent("remove", "BAT0", {}));
+
+    QCOMPARE(m_monitor->capacity(), -1);
+    QCOMPARE(changed.count(), 1);
+
+    // A supply that appears later is read from the tree first
+    m_monitor->injectUevent(uevent("add", "BAT0", {}));
+
+    QCOMPARE(m_monitor->capacity(), 50);
+}
+
+void TestPowerSupplyMonitor::noMainsIsOnline()
+{
+    QVERIFY(QDir(m_directory->filePath("AC")).removeRecursively());
+
+    m_monitor->start(m_directory->path());
+
+    QVERIFY(m_monitor->isOnline());
+    QCOMPARE(m_monitor->capacity(), 50);
+}
+
+void TestPowerSupplyMonitor::unknownSourceRejected()
+{
+    QJsonArray rulesArray
+    {
+        QJsonObject{ { "source", "AC" }, { "preset", "turbo" }, { "priority", 1 } },
+        QJsonObject{ { "source", "battery" }, { "preset", "silence" }, { "priority", 1 } },
+        QJsonObject{ { "preset", "silence" }, { "priority", 0 } },
+    };
+
+    const QString presetsPath = m_directory->writePresets({ { "powerSupply", QJsonObject{ { "rules", rulesArray } } } });
+    QVERIFY(!presetsPath.isEmpty());
+
+    PresetEngine engine(presetsPath);
+    engine.readPresets();
+
+    // "AC" would have matched on battery, a rule without a source is "any"
+    const QList<PowerRule>& rules = engine.presets().powerSupply.rules;
+    QCOMPARE(rules.size(), 2);
+    QCOMPARE(rules[0].source, QString("battery"));
+    QCOMPARE(rules[1].source, QString("any"));
+}
+
+QByteArray TestPowerSupplyMonitor::uevent(const QByteArray& action, const QByteArray& name, const QByteArrayList& fields)
+{
+    // The kernel format, NUL separated with a header line first
+    QByteArrayList message{ action + "@/devices/platform/" + name, "ACTION=" + action, "SUBSYSTEM=power_supply", "POWER_SUPPLY_NAME=" + name };
+    message << fields;
+
+    return message.join('\0');
+}
+
+QTEST_GUILESS_MAIN(TestPowerSupplyMonitor)
+
+#include "TestPowerSupplyMonitor.moc"
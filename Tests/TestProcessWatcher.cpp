@@ -0,0 +1,136 @@
+#include <QProcess>
+#include <QSignalSpy>
+#include <QTest>
+
+#include <memory>
+
+#include "ProcessWatcher.h"
+
+#ifdef Q_OS_LINUX
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#endif
+
+// A sleep child matched by name, its exec and exit come in as injected
+// process connector messages
+class TestProcessWatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void execAndExit();
+    void lostExitRescanned();
+
+private:
+    static QByteArray procEvent(uint32_t what, int32_t pid);
+
+    std::unique_ptr<QProcess> m_process;
+    std::unique_ptr<ProcessWatcher> m_watcher;
+};
+
+void TestProcessWatcher::init()
+{
+    m_process = std::make_unique<QProcess>();
+    m_process->start("sleep", { "30" });
+
+    // Only returns once the child is past exec, so /proc has its comm
+    if (!m_process->waitForStarted())
+        QSKIP("No sleep to start");
+
+    m_watcher = std::make_unique<ProcessWatcher>();
+    m_watcher->setRules({ { { "sleep" }, {}, "turbo", 20 } });
+}
+
+void TestProcessWatcher::cleanup()
+{
+    m_watcher.reset();
+
+    if (m_process->state() != QProcess::NotRunning)
+    {
+        m_process->kill();
+        m_process->waitForFinished();
+    }
+
+    m_process.reset();
+}
+
+void TestProcessWatcher::execAndExit()
+{
+#ifdef Q_OS_LINUX
+    QSignalSpy requested(m_watcher.get(), &ProcessWatcher::presetRequested);
+    QSignalSpy released(m_watcher.get(), &ProcessWatcher::presetReleased);
+
+    const int32_t pid = static_cast<int32_t>(m_process->processId());
+
+    m_watcher->injectMessage(procEvent(0x00000002, pid));
+
+    QCOMPARE(requested.count(), 1);
+    QCOMPARE(requested.at(0).at(0).toString(), QString("turbo"));
+    QCOMPARE(requested.at(0).at(1).toInt(), 20);
+
+    m_process->kill();
+    QVERIFY(m_process->waitForFinished());
+
+    m_watcher->injectMessage(procEvent(0x80000000, pid));
+
+    QCOMPARE(released.count(), 1);
+#else
+    QSKIP("The process connector is Linux only");
+#endif
+}
+
+void TestProcessWatcher::lostExitRescanned()
+{
+#ifdef Q_OS_LINUX
+    QSignalSpy released(m_watcher.get(), &ProcessWatcher::presetReleased);
+
+    m_watcher->injectMessage(procEvent(0x00000002, static_cast<int32_t>(m_process->processId())));
+
+    // The exit is dropped as on ENOBUFS, the rescan has to find it. The child
+    // started after the last scan, so it is only known from the connector.
+    m_process->kill();
+    QVERIFY(m_process->waitForFinished());
+
+    QVERIFY(QMetaObject::invokeMethod(m_watcher.get(), "scanProcesses"));
+
+    QCOMPARE(released.count(), 1);
+#else
+    QSKIP("The process connector is Linux only");
+#endif
+}
+
+QByteArray TestProcessWatcher::procEvent(uint32_t what, int32_t pid)
+{
+#ifdef Q_OS_LINUX
+    QByteArray message(NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_event)), '\0');
+
+    nlmsghdr* header = reinterpret_cast<nlmsghdr*>(message.data());
+    header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_event));
+    header->nlmsg_type = NLMSG_DONE;
+
+    cn_msg* connectorMessage = reinterpret_cast<cn_msg*>(NLMSG_DATA(header));
+    connectorMessage->id.idx = CN_IDX_PROC;
+    connectorMessage->id.val = CN_VAL_PROC;
+    connectorMessage->len = sizeof(proc_event);
+
+    // Exec and exit both start with the pid and tgid
+    proc_event* event = reinterpret_cast<proc_event*>(connectorMessage->data);
+    event->what = static_cast<decltype(event->what)>(what);
+    event->event_data.exec.process_pid = pid;
+    event->event_data.exec.process_tgid = pid;
+
+    return message;
+#else
+    Q_UNUSED(what);
+    Q_UNUSED(pid);
+    return QByteArray();
+#endif
+}
+
+QTEST_GUILESS_MAIN(TestProcessWatcher)
+
+#include "TestProcessWatcher.moc"
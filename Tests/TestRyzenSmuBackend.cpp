@@ -0,0 +1,86 @@
+#include <QTest>
+
+#include <memory>
+
+#include "FakeRyzenSmu.h"
+#include "RyzenSmuBackend.h"
+
+// RyzenSmuBackend against the fake mailbox of the benchmarks, which answers
+// like the ryzen_smu driver and puts the limits into its PM table
+class TestRyzenSmuBackend : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void applyAndReadBack();
+    void unsupportedArg();
+    void timeout();
+    void missingDriver();
+
+private:
+    std::unique_ptr<FakeRyzenSmu> m_smu;
+};
+
+void TestRyzenSmuBackend::init()
+{
+    m_smu = std::make_unique<FakeRyzenSmu>();
+    if (!m_smu->start())
+        QSKIP("The fake ryzen_smu mailbox needs Linux and inotify");
+}
+
+void TestRyzenSmuBackend::applyAndReadBack()
+{
+    RyzenSmuBackend backend(m_smu->path());
+    QVERIFY(backend.init());
+    QVERIFY(backend.isReady());
+
+    QCOMPARE(backend.applyArg("stapm-limit", 15000), 0);
+    QCOMPARE(backend.applyArg("fast-limit", 35000), 0);
+
+    backend.refreshTable();
+
+    Telemetry telemetry;
+    backend.readTelemetry(telemetry);
+
+    QCOMPARE(telemetry.stapmLimit, 15.0f);
+    QCOMPARE(telemetry.stapmValue, 12.0f);
+    QCOMPARE(telemetry.fastLimit, 35.0f);
+    QCOMPARE(telemetry.slowLimit, 0.0f);
+}
+
+void TestRyzenSmuBackend::unsupportedArg()
+{
+    RyzenSmuBackend backend(m_smu->path());
+    QVERIFY(backend.init());
+
+    QVERIFY(backend.hasArg("tctl-temp"));
+    QVERIFY(!backend.hasArg("max-fclk-frequency"));
+
+    QCOMPARE(backend.applyArg("max-fclk-frequency", 1800), g_smuErrorUnsupported);
+}
+
+void TestRyzenSmuBackend::timeout()
+{
+    RyzenSmuBackend backend(m_smu->path());
+    QVERIFY(backend.init());
+
+    // The files stay, but nobody answers the mailbox anymore
+    m_smu->stop();
+
+    QCOMPARE(backend.applyArg("slow-limit", 15000), g_smuErrorTimeout);
+}
+
+void TestRyzenSmuBackend::missingDriver()
+{
+    RyzenSmuBackend backend(m_smu->path() + "/missing");
+
+    QVERIFY(!backend.init());
+    QVERIFY(!backend.isReady());
+    QCOMPARE(backend.applyArg("stapm-limit", 15000), g_smuErrorAccess);
+}
+
+QTEST_GUILESS_MAIN(TestRyzenSmuBackend)
+
+#include "TestRyzenSmuBackend.moc"
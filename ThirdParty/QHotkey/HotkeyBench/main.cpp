@@ -0,0 +1,253 @@
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QHotkey>
+#include <QThread>
+#include <QTimer>
+
+#include <X11/Xlib.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XTest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/uinput.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Measures the time from a synthetic XTest key event to the activated and
+// released signals, or with "register" the cost of registering many hotkeys
+// one by one against a single batch. Meant to run on a private server:
+//   xvfb-run -a ./HotkeyBench 1000
+//   xvfb-run -a ./HotkeyBench register 24
+// "evdev" does the same through a uinput keyboard and the evdev backend, it
+// needs write access to /dev/uinput but no display:
+//   ./HotkeyBench evdev 1000
+
+enum BenchKey {
+	ControlKey,
+	AltKey,
+	HotkeyKey
+};
+
+using SendKey = std::function<void(BenchKey, bool)>;
+
+static void printLatencies(const char *name, std::vector<qint64> &latencies)
+{
+	if(latencies.empty())
+		return;
+
+	std::sort(latencies.begin(), latencies.end());
+	auto at = [&latencies](double quantile) {
+		return latencies[std::min(latencies.size() - 1, static_cast<size_t>(quantile * latencies.size()))] / 1000.0;
+	};
+
+	std::printf("%-8s min %8.1f us, median %8.1f us, p99 %8.1f us, max %8.1f us\n",
+				name, latencies.front() / 1000.0, at(0.5), at(0.99), latencies.back() / 1000.0);
+}
+
+static int benchmarkRegistration(int count)
+{
+	const Qt::KeyboardModifiers modifierSets[] = {
+		Qt::ControlModifier | Qt::AltModifier,
+		Qt::ControlModifier | Qt::ShiftModifier,
+		Qt::AltModifier | Qt::ShiftModifier,
+		Qt::ControlModifier | Qt::AltModifier | Qt::ShiftModifier
+	};
+
+	count = std::min(count, 48);
+
+	QList<QHotkey *> hotkeys;
+	for(int i = 0; i < count; ++i)
+		hotkeys.append(new QHotkey(Qt::Key(Qt::Key_F1 + i % 12), modifierSets[i / 12], false));
+
+	std::vector<qint64> singleAdd, singleRemove, batchAdd, batchRemove;
+	QElapsedTimer timer;
+	int registered = 0;
+
+	for(int round = 0; round < 20; ++round) {
+		timer.start();
+		for(QHotkey *hotkey : std::as_const(hotkeys))
+			hotkey->setRegistered(true);
+		singleAdd.push_back(timer.nsecsElapsed());
+
+		timer.start();
+		for(QHotkey *hotkey : std::as_const(hotkeys))
+			hotkey->setRegistered(false);
+		singleRemove.push_back(timer.nsecsElapsed());
+
+		timer.start();
+		registered = QHotkey::registerHotkeys(hotkeys);
+		batchAdd.push_back(timer.nsecsElapsed());
+
+		timer.start();
+		QHotkey::unregisterHotkeys(hotkeys);
+		batchRemove.push_back(timer.nsecsElapsed());
+	}
+
+	qDeleteAll(hotkeys);
+
+	std::printf("%d hotkeys, %d registered by the batch, 20 rounds\n", count, registered);
+	printLatencies("single+", singleAdd);
+	printLatencies("single-", singleRemove);
+	printLatencies("batch+", batchAdd);
+	printLatencies("batch-", batchRemove);
+
+	return registered == count ? 0 : 1;
+}
+
+static int benchmarkLatency(QGuiApplication &app, int count, const SendKey &sendKey)
+{
+	QHotkey hotkey(QKeySequence(Qt::ControlModifier | Qt::AltModifier | Qt::Key_F12), true);
+	if(!hotkey.isRegistered()) {
+		std::fprintf(stderr, "Failed to register the hotkey\n");
+		return 1;
+	}
+
+	std::vector<qint64> pressLatencies;
+	std::vector<qint64> releaseLatencies;
+	pressLatencies.reserve(count);
+	releaseLatencies.reserve(count);
+
+	QElapsedTimer timer;
+	int activations = 0;
+	int releases = 0;
+
+	QObject::connect(&hotkey, &QHotkey::activated, [&]() {
+		pressLatencies.push_back(timer.nsecsElapsed());
+		++activations;
+
+		timer.start();
+		sendKey(HotkeyKey, false);
+	});
+
+	QObject::connect(&hotkey, &QHotkey::released, [&]() {
+		releaseLatencies.push_back(timer.nsecsElapsed());
+		++releases;
+
+		if(releases == count) {
+			sendKey(AltKey, false);
+			sendKey(ControlKey, false);
+			app.quit();
+			return;
+		}
+
+		timer.start();
+		sendKey(HotkeyKey, true);
+	});
+
+	sendKey(ControlKey, true);
+	sendKey(AltKey, true);
+
+	QTimer::singleShot(0, [&]() {
+		timer.start();
+		sendKey(HotkeyKey, true);
+	});
+
+	// stops a run that lost events instead of hanging
+	QTimer::singleShot(60000 + count * 100, &app, &QCoreApplication::quit);
+
+	app.exec();
+
+	std::printf("%d presses, %d activations, %d releases\n", count, activations, releases);
+	printLatencies("press", pressLatencies);
+	printLatencies("release", releaseLatencies);
+
+	return releases == count ? 0 : 1;
+}
+
+static int benchmarkX11(QGuiApplication &app, int count)
+{
+	// a connection of its own, so the injected events travel like real input
+	Display *display = XOpenDisplay(nullptr);
+	int eventBase, errorBase, major, minor;
+	if(!display || !XTestQueryExtension(display, &eventBase, &errorBase, &major, &minor)) {
+		std::fprintf(stderr, "XTest is not available\n");
+		return 1;
+	}
+
+	const KeyCode keycodes[] = {
+		XKeysymToKeycode(display, XK_Control_L),
+		XKeysymToKeycode(display, XK_Alt_L),
+		XKeysymToKeycode(display, XK_F12)
+	};
+
+	int result = benchmarkLatency(app, count, [&](BenchKey key, bool press) {
+		XTestFakeKeyEvent(display, keycodes[key], press ? True : False, CurrentTime);
+		XFlush(display);
+	});
+
+	XCloseDisplay(display);
+	return result;
+}
+
+static int benchmarkEvdev(QGuiApplication &app, int count)
+{
+	int fd = ::open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+	if(fd < 0) {
+		std::fprintf(stderr, "Failed to open /dev/uinput: %s\n", std::strerror(errno));
+		return 1;
+	}
+
+	const int codes[] = { KEY_LEFTCTRL, KEY_LEFTALT, KEY_F12 };
+
+	// KEY_A and KEY_ENTER make the backend take the device for a keyboard
+	::ioctl(fd, UI_SET_EVBIT, EV_KEY);
+	for(int code : { KEY_LEFTCTRL, KEY_LEFTALT, KEY_F12, KEY_A, KEY_ENTER })
+		::ioctl(fd, UI_SET_KEYBIT, code);
+
+	uinput_setup setup = {};
+	setup.id.bustype = BUS_VIRTUAL;
+	std::strcpy(setup.name, "QHotkey benchmark keyboard");
+
+	if(::ioctl(fd, UI_DEV_SETUP, &setup) < 0 || ::ioctl(fd, UI_DEV_CREATE) < 0) {
+		std::fprintf(stderr, "Failed to create the uinput device: %s\n", std::strerror(errno));
+		::close(fd);
+		return 1;
+	}
+
+	// the event node has to exist before the backend scans /dev/input
+	QThread::msleep(500);
+
+	int result = benchmarkLatency(app, count, [fd, &codes](BenchKey key, bool press) {
+		input_event events[2] = {};
+		events[0].type = EV_KEY;
+		events[0].code = codes[key];
+		events[0].value = press ? 1 : 0;
+		events[1].type = EV_SYN;
+		events[1].code = SYN_REPORT;
+
+		ssize_t written = ::write(fd, events, sizeof(events));
+		Q_UNUSED(written)
+	});
+
+	::ioctl(fd, UI_DEV_DESTROY);
+	::close(fd);
+	return result;
+}
+
+int main(int argc, char *argv[])
+{
+	const bool evdev = argc > 1 && std::strcmp(argv[1], "evdev") == 0;
+	if(evdev) {
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+		qputenv("QHOTKEY_BACKEND", "evdev");
+	}
+
+	QGuiApplication app(argc, argv);
+
+	if(argc > 1 && std::strcmp(argv[1], "register") == 0)
+		return benchmarkRegistration(argc > 2 ? std::max(1, std::atoi(argv[2])) : 24);
+
+	if(evdev)
+		return benchmarkEvdev(app, argc > 2 ? std::max(1, std::atoi(argv[2])) : 1000);
+
+	return benchmarkX11(app, argc > 1 ? std::max(1, std::atoi(argv[1])) : 1000);
+}
@@ -5,6 +5,7 @@
 #include <QMetaMethod>
 #include <QThread>
 #include <QDebug>
+#include <utility>
 
 Q_LOGGING_CATEGORY(logQHotkey, "QHotkey")
 
@@ -27,6 +28,16 @@ bool QHotkey::isPlatformSupported()
 	return QHotkeyPrivate::isPlatformSupported();
 }
 
+int QHotkey::registerHotkeys(const QList<QHotkey *> &hotkeys)
+{
+	return QHotkeyPrivate::instance()->addShortcuts(hotkeys);
+}
+
+int QHotkey::unregisterHotkeys(const QList<QHotkey *> &hotkeys)
+{
+	return QHotkeyPrivate::instance()->removeShortcuts(hotkeys);
+}
+
 QHotkey::QHotkey(QObject *parent) :
 	QObject(parent),
 	_keyCode(Qt::Key_unknown),
@@ -266,18 +277,92 @@ bool QHotkeyPrivate::removeShortcut(QHotkey *hotkey)
 	return res;
 }
 
-void QHotkeyPrivate::activateShortcut(QHotkey::NativeShortcut shortcut)
+int QHotkeyPrivate::addShortcuts(const QList<QHotkey *> &hotkeys)
+{
+	Qt::ConnectionType conType = (QThread::currentThread() == thread() ?
+									  Qt::DirectConnection :
+									  Qt::BlockingQueuedConnection);
+	QList<QHotkey *> pending;
+	for(QHotkey *hotkey : hotkeys) {
+		if(!hotkey->_registered)
+			pending.append(hotkey);
+	}
+
+	int res = 0;
+	if(!QMetaObject::invokeMethod(this, "addShortcutsInvoked", conType,
+								  Q_RETURN_ARG(int, res),
+								  Q_ARG(QList<QHotkey *>, pending))) {
+		return 0;
+	}
+
+	for(QHotkey *hotkey : std::as_const(pending)) {
+		if(hotkey->_registered)
+			emit hotkey->registeredChanged(true);
+	}
+	return res;
+}
+
+int QHotkeyPrivate::removeShortcuts(const QList<QHotkey *> &hotkeys)
+{
+	Qt::ConnectionType conType = (QThread::currentThread() == thread() ?
+									  Qt::DirectConnection :
+									  Qt::BlockingQueuedConnection);
+	QList<QHotkey *> pending;
+	for(QHotkey *hotkey : hotkeys) {
+		if(hotkey->_registered)
+			pending.append(hotkey);
+	}
+
+	int res = 0;
+	if(!QMetaObject::invokeMethod(this, "removeShortcutsInvoked", conType,
+								  Q_RETURN_ARG(int, res),
+								  Q_ARG(QList<QHotkey *>, pending))) {
+		return 0;
+	}
+
+	for(QHotkey *hotkey : std::as_const(pending)) {
+		if(!hotkey->_registered)
+			emit hotkey->registeredChanged(false);
+	}
+	return res;
+}
+
+void QHotkeyPrivate::registerShortcuts(const QList<QHotkey::NativeShortcut> &shortcuts, QStringList &errors)
+{
+	errors.clear();
+	for(QHotkey::NativeShortcut shortcut : shortcuts) {
+		error.clear();
+		if(registerShortcut(shortcut))
+			errors.append(QString());
+		else
+			errors.append(error.isEmpty() ? QStringLiteral("Unknown error") : error);
+	}
+}
+
+void QHotkeyPrivate::unregisterShortcuts(const QList<QHotkey::NativeShortcut> &shortcuts, QStringList &errors)
+{
+	errors.clear();
+	for(QHotkey::NativeShortcut shortcut : shortcuts) {
+		error.clear();
+		if(unregisterShortcut(shortcut))
+			errors.append(QString());
+		else
+			errors.append(error.isEmpty() ? QStringLiteral("Unknown error") : error);
+	}
+}
+
+void QHotkeyPrivate::activateShortcut(QHotkey::NativeShortcut shortcut, Qt::ConnectionType type)
 {
 	QMetaMethod signal = QMetaMethod::fromSignal(&QHotkey::activated);
 	for(QHotkey *hkey : shortcuts.values(shortcut))
-		signal.invoke(hkey, Qt::QueuedConnection);
+		signal.invoke(hkey, type);
 }
 
-void QHotkeyPrivate::releaseShortcut(QHotkey::NativeShortcut shortcut)
+void QHotkeyPrivate::releaseShortcut(QHotkey::NativeShortcut shortcut, Qt::ConnectionType type)
 {
 	QMetaMethod signal = QMetaMethod::fromSignal(&QHotkey::released);
 	for(QHotkey *hkey : shortcuts.values(shortcut))
-		signal.invoke(hkey, Qt::QueuedConnection);
+		signal.invoke(hkey, type);
 }
 
 void QHotkeyPrivate::addMappingInvoked(Qt::Key keycode, Qt::KeyboardModifiers modifiers, QHotkey::NativeShortcut nativeShortcut)
@@ -319,6 +404,66 @@ bool QHotkeyPrivate::removeShortcutInvoked(QHotkey *hotkey)
 	return true;
 }
 
+int QHotkeyPrivate::addShortcutsInvoked(const QList<QHotkey *> &hotkeys)
+{
+	//every native shortcut is grabbed once, even if several hotkeys share it
+	QList<QHotkey::NativeShortcut> natives;
+	for(QHotkey *hotkey : hotkeys) {
+		QHotkey::NativeShortcut shortcut = hotkey->_nativeShortcut;
+		if(shortcut.isValid() && !shortcuts.contains(shortcut) && !natives.contains(shortcut))
+			natives.append(shortcut);
+	}
+
+	QStringList errors;
+	if(!natives.isEmpty())
+		registerShortcuts(natives, errors);
+
+	int count = 0;
+	for(QHotkey *hotkey : hotkeys) {
+		QHotkey::NativeShortcut shortcut = hotkey->_nativeShortcut;
+		if(hotkey->_registered || !shortcut.isValid())
+			continue;
+
+		int index = natives.indexOf(shortcut);
+		if(index >= 0 && !errors.value(index).isNull()) {
+			qCWarning(logQHotkey) << QHotkey::tr("Failed to register %1. Error: %2").arg(hotkey->shortcut().toString(), errors.value(index));
+			continue;
+		}
+
+		shortcuts.insert(shortcut, hotkey);
+		hotkey->_registered = true;
+		++count;
+	}
+	return count;
+}
+
+int QHotkeyPrivate::removeShortcutsInvoked(const QList<QHotkey *> &hotkeys)
+{
+	QList<QHotkey::NativeShortcut> natives;
+	int count = 0;
+	for(QHotkey *hotkey : hotkeys) {
+		QHotkey::NativeShortcut shortcut = hotkey->_nativeShortcut;
+		if(shortcuts.remove(shortcut, hotkey) == 0)
+			continue;
+
+		hotkey->_registered = false;
+		++count;
+
+		if(shortcuts.count(shortcut) == 0 && !natives.contains(shortcut))
+			natives.append(shortcut);
+	}
+
+	QStringList errors;
+	if(!natives.isEmpty())
+		unregisterShortcuts(natives, errors);
+
+	for(int i = 0; i < errors.size(); ++i) {
+		if(!errors[i].isNull())
+			qCWarning(logQHotkey) << QHotkey::tr("Failed to unregister native key %1. Error: %2").arg(natives[i].key).arg(errors[i]);
+	}
+	return count;
+}
+
 QHotkey::NativeShortcut QHotkeyPrivate::nativeShortcutInvoked(Qt::Key keycode, Qt::KeyboardModifiers modifiers)
 {
 	if(mapping.contains({keycode, modifiers}))
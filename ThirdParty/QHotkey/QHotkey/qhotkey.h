@@ -66,6 +66,11 @@ public:
 	//! Checks if global shortcuts are supported by the current platform
 	static bool isPlatformSupported();
 
+	//! Registers all given hotkeys at once, with a single round trip to the window system where possible
+	static int registerHotkeys(const QList<QHotkey *> &hotkeys);
+	//! Unregisters all given hotkeys at once, with a single round trip to the window system where possible
+	static int unregisterHotkeys(const QList<QHotkey *> &hotkeys);
+
 	//! Default Constructor
 	explicit QHotkey(QObject *parent = nullptr);
 	//! Constructs a hotkey with a shortcut and optionally registers it
@@ -0,0 +1,523 @@
+#include "qhotkey.h"
+#include "qhotkey_p.h"
+
+#include <QDir>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThread>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <utility>
+
+// Reads key events straight from /dev/input/event* on a thread of its own, so
+// hotkeys work on Wayland and without any display. The devices are not
+// grabbed, other applications still see every key.
+// QHOTKEY_EVDEV_DEVICES takes a colon separated list of devices (or fifos fed
+// with raw input_event records) instead of scanning /dev/input, and
+// QHOTKEY_BACKEND=evdev forces this backend where X11 is available.
+class QHotkeyPrivateEvdev : public QHotkeyPrivate
+{
+public:
+	QHotkeyPrivateEvdev();
+	~QHotkeyPrivateEvdev() override;
+
+	static bool isAvailable();
+
+	// QAbstractNativeEventFilter interface
+	bool nativeEventFilter(const QByteArray &eventType, void *message, _NATIVE_EVENT_RESULT *result) override;
+
+protected:
+	// QHotkeyPrivate interface
+	quint32 nativeKeycode(Qt::Key keycode, bool &ok) Q_DECL_OVERRIDE;
+	quint32 nativeModifiers(Qt::KeyboardModifiers modifiers, bool &ok) Q_DECL_OVERRIDE;
+	bool registerShortcut(QHotkey::NativeShortcut shortcut) Q_DECL_OVERRIDE;
+	bool unregisterShortcut(QHotkey::NativeShortcut shortcut) Q_DECL_OVERRIDE;
+
+private:
+	struct Device {
+		int fd = -1;
+		QByteArray path;
+		//one bit per modifier key, left and right apart
+		quint32 modifierKeys = 0;
+	};
+
+	static quint64 shortcutId(quint32 key, quint32 modifier);
+	static int modifierBit(quint16 code);
+	static quint32 modifierMask(quint32 modifierKeys);
+
+	bool startReader();
+	void stopReader();
+	void readLoop();
+	void readNotifications();
+	bool addDevice(const QByteArray &path, bool listed);
+	void removeDevice(int fd);
+	bool readDevice(Device &device);
+	void handleKey(Device &device, quint16 code, qint32 value);
+
+	//registered shortcuts, written by the gui thread and read by the reader
+	QMutex shortcutsMutex;
+	QSet<quint64> nativeShortcuts;
+
+	//owned by the reader thread once it runs
+	int epollFd = -1;
+	int stopFd = -1;
+	int notifyFd = -1;
+	QHash<int, Device> devices;
+	QHash<quint16, QHotkey::NativeShortcut> pressedShortcuts;
+
+	QThread *readerThread = nullptr;
+};
+
+Q_GLOBAL_STATIC(QHotkeyPrivateEvdev, hotkeyPrivateEvdev)
+
+#ifdef QHOTKEY_X11
+QHotkeyPrivate *qhotkeyX11Instance();
+bool qhotkeyX11Supported();
+#endif
+
+static bool useEvdev()
+{
+#ifdef QHOTKEY_X11
+	const QByteArray backend = qgetenv("QHOTKEY_BACKEND");
+	if(backend == "evdev")
+		return true;
+	if(backend == "x11")
+		return false;
+	return !qhotkeyX11Supported();
+#else
+	return true;
+#endif
+}
+
+QHotkeyPrivate *QHotkeyPrivate::instance()
+{
+	//decided once, shortcuts must never move between backends
+	static const bool evdev = useEvdev();
+#ifdef QHOTKEY_X11
+	if(!evdev)
+		return qhotkeyX11Instance();
+#endif
+	Q_UNUSED(evdev)
+	return hotkeyPrivateEvdev;
+}
+
+bool QHotkeyPrivate::isPlatformSupported()
+{
+#ifdef QHOTKEY_X11
+	if(!useEvdev())
+		return qhotkeyX11Supported();
+#endif
+	return QHotkeyPrivateEvdev::isAvailable();
+}
+
+static const QHash<int, quint32> &keyTable()
+{
+	//positions of a US layout, evdev has no notion of the active keymap
+	static const QHash<int, quint32> table = {
+		{Qt::Key_A, KEY_A}, {Qt::Key_B, KEY_B}, {Qt::Key_C, KEY_C}, {Qt::Key_D, KEY_D},
+		{Qt::Key_E, KEY_E}, {Qt::Key_F, KEY_F}, {Qt::Key_G, KEY_G}, {Qt::Key_H, KEY_H},
+		{Qt::Key_I, KEY_I}, {Qt::Key_J, KEY_J}, {Qt::Key_K, KEY_K}, {Qt::Key_L, KEY_L},
+		{Qt::Key_M, KEY_M}, {Qt::Key_N, KEY_N}, {Qt::Key_O, KEY_O}, {Qt::Key_P, KEY_P},
+		{Qt::Key_Q, KEY_Q}, {Qt::Key_R, KEY_R}, {Qt::Key_S, KEY_S}, {Qt::Key_T, KEY_T},
+		{Qt::Key_U, KEY_U}, {Qt::Key_V, KEY_V}, {Qt::Key_W, KEY_W}, {Qt::Key_X, KEY_X},
+		{Qt::Key_Y, KEY_Y}, {Qt::Key_Z, KEY_Z},
+		{Qt::Key_0, KEY_0}, {Qt::Key_1, KEY_1}, {Qt::Key_2, KEY_2}, {Qt::Key_3, KEY_3},
+		{Qt::Key_4, KEY_4}, {Qt::Key_5, KEY_5}, {Qt::Key_6, KEY_6}, {Qt::Key_7, KEY_7},
+		{Qt::Key_8, KEY_8}, {Qt::Key_9, KEY_9},
+		{Qt::Key_F1, KEY_F1}, {Qt::Key_F2, KEY_F2}, {Qt::Key_F3, KEY_F3}, {Qt::Key_F4, KEY_F4},
+		{Qt::Key_F5, KEY_F5}, {Qt::Key_F6, KEY_F6}, {Qt::Key_F7, KEY_F7}, {Qt::Key_F8, KEY_F8},
+		{Qt::Key_F9, KEY_F9}, {Qt::Key_F10, KEY_F10}, {Qt::Key_F11, KEY_F11}, {Qt::Key_F12, KEY_F12},
+		{Qt::Key_F13, KEY_F13}, {Qt::Key_F14, KEY_F14}, {Qt::Key_F15, KEY_F15}, {Qt::Key_F16, KEY_F16},
+		{Qt::Key_F17, KEY_F17}, {Qt::Key_F18, KEY_F18}, {Qt::Key_F19, KEY_F19}, {Qt::Key_F20, KEY_F20},
+		{Qt::Key_F21, KEY_F21}, {Qt::Key_F22, KEY_F22}, {Qt::Key_F23, KEY_F23}, {Qt::Key_F24, KEY_F24},
+		{Qt::Key_Escape, KEY_ESC}, {Qt::Key_Tab, KEY_TAB}, {Qt::Key_Backspace, KEY_BACKSPACE},
+		{Qt::Key_Return, KEY_ENTER}, {Qt::Key_Enter, KEY_KPENTER}, {Qt::Key_Space, KEY_SPACE},
+		{Qt::Key_Insert, KEY_INSERT}, {Qt::Key_Delete, KEY_DELETE}, {Qt::Key_Pause, KEY_PAUSE},
+		{Qt::Key_Print, KEY_SYSRQ}, {Qt::Key_ScrollLock, KEY_SCROLLLOCK}, {Qt::Key_Menu, KEY_COMPOSE},
+		{Qt::Key_Home, KEY_HOME}, {Qt::Key_End, KEY_END}, {Qt::Key_PageUp, KEY_PAGEUP}, {Qt::Key_PageDown, KEY_PAGEDOWN},
+		{Qt::Key_Left, KEY_LEFT}, {Qt::Key_Up, KEY_UP}, {Qt::Key_Right, KEY_RIGHT}, {Qt::Key_Down, KEY_DOWN},
+		{Qt::Key_Minus, KEY_MINUS}, {Qt::Key_Equal, KEY_EQUAL}, {Qt::Key_BracketLeft, KEY_LEFTBRACE},
+		{Qt::Key_BracketRight, KEY_RIGHTBRACE}, {Qt::Key_Semicolon, KEY_SEMICOLON}, {Qt::Key_Apostrophe, KEY_APOSTROPHE},
+		{Qt::Key_QuoteLeft, KEY_GRAVE}, {Qt::Key_Backslash, KEY_BACKSLASH}, {Qt::Key_Comma, KEY_COMMA},
+		{Qt::Key_Period, KEY_DOT}, {Qt::Key_Slash, KEY_SLASH},
+		{Qt::Key_VolumeUp, KEY_VOLUMEUP}, {Qt::Key_VolumeDown, KEY_VOLUMEDOWN}, {Qt::Key_VolumeMute, KEY_MUTE},
+		{Qt::Key_MediaPlay, KEY_PLAYPAUSE}, {Qt::Key_MediaTogglePlayPause, KEY_PLAYPAUSE}, {Qt::Key_MediaPause, KEY_PLAYPAUSE},
+		{Qt::Key_MediaNext, KEY_NEXTSONG}, {Qt::Key_MediaPrevious, KEY_PREVIOUSSONG}, {Qt::Key_MediaStop, KEY_STOPCD},
+		{Qt::Key_Launch0, KEY_PROG1}, {Qt::Key_Launch1, KEY_PROG2}
+	};
+	return table;
+}
+
+static bool testBit(const unsigned long *bits, int bit)
+{
+	return (bits[bit / (CHAR_BIT * sizeof(long))] >> (bit % (CHAR_BIT * sizeof(long)))) & 1UL;
+}
+
+//modifier keys in bit order, two per native modifier
+static const quint16 modifierCodes[] = {
+	KEY_LEFTSHIFT, KEY_RIGHTSHIFT,
+	KEY_LEFTCTRL, KEY_RIGHTCTRL,
+	KEY_LEFTALT, KEY_RIGHTALT,
+	KEY_LEFTMETA, KEY_RIGHTMETA
+};
+
+static const quint32 ShiftModifier = 0x01;
+static const quint32 ControlModifier = 0x02;
+static const quint32 AltModifier = 0x04;
+static const quint32 MetaModifier = 0x08;
+
+QHotkeyPrivateEvdev::QHotkeyPrivateEvdev()
+{
+}
+
+QHotkeyPrivateEvdev::~QHotkeyPrivateEvdev()
+{
+	stopReader();
+}
+
+bool QHotkeyPrivateEvdev::isAvailable()
+{
+	if(!qEnvironmentVariableIsEmpty("QHOTKEY_EVDEV_DEVICES"))
+		return true;
+
+	const QStringList entries = QDir(QStringLiteral("/dev/input")).entryList({QStringLiteral("event*")}, QDir::System);
+	for(const QString &entry : entries) {
+		if(::access(QByteArray("/dev/input/" + entry.toLatin1()).constData(), R_OK) == 0)
+			return true;
+	}
+	return false;
+}
+
+bool QHotkeyPrivateEvdev::nativeEventFilter(const QByteArray &eventType, void *message, _NATIVE_EVENT_RESULT *result)
+{
+	Q_UNUSED(eventType)
+	Q_UNUSED(message)
+	Q_UNUSED(result)
+	return false;
+}
+
+quint32 QHotkeyPrivateEvdev::nativeKeycode(Qt::Key keycode, bool &ok)
+{
+	auto it = keyTable().constFind(keycode);
+	ok = it != keyTable().constEnd();
+	return ok ? it.value() : 0;
+}
+
+quint32 QHotkeyPrivateEvdev::nativeModifiers(Qt::KeyboardModifiers modifiers, bool &ok)
+{
+	quint32 nMods = 0;
+	if (modifiers & Qt::ShiftModifier)
+		nMods |= ShiftModifier;
+	if (modifiers & Qt::ControlModifier)
+		nMods |= ControlModifier;
+	if (modifiers & Qt::AltModifier)
+		nMods |= AltModifier;
+	if (modifiers & Qt::MetaModifier)
+		nMods |= MetaModifier;
+	ok = true;
+	return nMods;
+}
+
+bool QHotkeyPrivateEvdev::registerShortcut(QHotkey::NativeShortcut shortcut)
+{
+	if(!readerThread && !startReader())
+		return false;
+
+	QMutexLocker locker(&shortcutsMutex);
+	nativeShortcuts.insert(shortcutId(shortcut.key, shortcut.modifier));
+	return true;
+}
+
+bool QHotkeyPrivateEvdev::unregisterShortcut(QHotkey::NativeShortcut shortcut)
+{
+	QMutexLocker locker(&shortcutsMutex);
+	nativeShortcuts.remove(shortcutId(shortcut.key, shortcut.modifier));
+	return true;
+}
+
+quint64 QHotkeyPrivateEvdev::shortcutId(quint32 key, quint32 modifier)
+{
+	return (static_cast<quint64>(key) << 32) | modifier;
+}
+
+int QHotkeyPrivateEvdev::modifierBit(quint16 code)
+{
+	for(int i = 0; i < 8; ++i) {
+		if(modifierCodes[i] == code)
+			return i;
+	}
+	return -1;
+}
+
+quint32 QHotkeyPrivateEvdev::modifierMask(quint32 modifierKeys)
+{
+	quint32 mask = 0;
+	if(modifierKeys & 0x03)
+		mask |= ShiftModifier;
+	if(modifierKeys & 0x0C)
+		mask |= ControlModifier;
+	if(modifierKeys & 0x30)
+		mask |= AltModifier;
+	if(modifierKeys & 0xC0)
+		mask |= MetaModifier;
+	return mask;
+}
+
+bool QHotkeyPrivateEvdev::startReader()
+{
+	epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+	stopFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if(epollFd < 0 || stopFd < 0) {
+		error = QString::fromLocal8Bit(std::strerror(errno));
+		stopReader();
+		return false;
+	}
+
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.fd = stopFd;
+	::epoll_ctl(epollFd, EPOLL_CTL_ADD, stopFd, &event);
+
+	const QByteArray listed = qgetenv("QHOTKEY_EVDEV_DEVICES");
+	if(!listed.isEmpty()) {
+		for(const QByteArray &path : listed.split(':')) {
+			if(!path.isEmpty())
+				addDevice(path, true);
+		}
+	} else {
+		//keyboards plugged in later show up here
+		notifyFd = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+		if(notifyFd >= 0 && ::inotify_add_watch(notifyFd, "/dev/input", IN_CREATE | IN_ATTRIB) >= 0) {
+			event.data.fd = notifyFd;
+			::epoll_ctl(epollFd, EPOLL_CTL_ADD, notifyFd, &event);
+		}
+
+		const QStringList entries = QDir(QStringLiteral("/dev/input")).entryList({QStringLiteral("event*")}, QDir::System);
+		for(const QString &entry : entries)
+			addDevice("/dev/input/" + entry.toLatin1(), false);
+	}
+
+	if(devices.isEmpty() && notifyFd < 0) {
+		error = QStringLiteral("No readable keyboard device");
+		stopReader();
+		return false;
+	}
+
+	if(devices.isEmpty())
+		qCWarning(logQHotkey) << "No readable keyboard in /dev/input yet, the user needs to be in the input group";
+
+	readerThread = QThread::create([this]() { readLoop(); });
+	readerThread->setObjectName(QStringLiteral("QHotkey evdev"));
+	readerThread->start(QThread::TimeCriticalPriority);
+	return true;
+}
+
+void QHotkeyPrivateEvdev::stopReader()
+{
+	if(readerThread) {
+		const quint64 value = 1;
+		ssize_t written = ::write(stopFd, &value, sizeof(value));
+		Q_UNUSED(written)
+
+		readerThread->wait();
+		delete readerThread;
+		readerThread = nullptr;
+	}
+
+	for(const Device &device : std::as_const(devices))
+		::close(device.fd);
+	devices.clear();
+	pressedShortcuts.clear();
+
+	for(int *fd : {&notifyFd, &stopFd, &epollFd}) {
+		if(*fd >= 0)
+			::close(*fd);
+		*fd = -1;
+	}
+}
+
+void QHotkeyPrivateEvdev::readLoop()
+{
+	epoll_event events[16];
+
+	forever {
+		int count = ::epoll_wait(epollFd, events, 16, -1);
+		if(count < 0) {
+			if(errno == EINTR)
+				continue;
+			qCWarning(logQHotkey) << "epoll_wait failed:" << std::strerror(errno);
+			return;
+		}
+
+		for(int i = 0; i < count; ++i) {
+			const int fd = events[i].data.fd;
+			if(fd == stopFd)
+				return;
+
+			if(fd == notifyFd) {
+				readNotifications();
+				continue;
+			}
+
+			auto it = devices.find(fd);
+			if(it == devices.end())
+				continue;
+
+			if(!readDevice(it.value()))
+				removeDevice(fd);
+		}
+	}
+}
+
+void QHotkeyPrivateEvdev::readNotifications()
+{
+	alignas(inotify_event) char buffer[4096];
+
+	forever {
+		ssize_t size = ::read(notifyFd, buffer, sizeof(buffer));
+		if(size <= 0)
+			return;
+
+		for(ssize_t offset = 0; offset < size;) {
+			const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			//attributes change once udev has set the permissions
+			if(event->len > 0 && std::strncmp(event->name, "event", 5) == 0)
+				addDevice(QByteArray("/dev/input/") + event->name, false);
+		}
+	}
+}
+
+bool QHotkeyPrivateEvdev::addDevice(const QByteArray &path, bool listed)
+{
+	for(const Device &device : std::as_const(devices)) {
+		if(device.path == path)
+			return true;
+	}
+
+	int fd = ::open(path.constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if(fd < 0) {
+		if(listed)
+			qCWarning(logQHotkey) << "Failed to open" << path << std::strerror(errno);
+		return false;
+	}
+
+	Device device;
+	device.fd = fd;
+	device.path = path;
+
+	unsigned long keyBits[KEY_MAX / (CHAR_BIT * sizeof(long)) + 1] = {};
+	bool isKeyboard = ::ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits) >= 0 &&
+					  testBit(keyBits, KEY_A) && testBit(keyBits, KEY_ENTER);
+
+	//listed paths may be fifos for injected events, they pass without the check
+	if(!isKeyboard && !listed) {
+		::close(fd);
+		return false;
+	}
+
+	//modifiers already held down when the device is opened
+	unsigned long keyState[KEY_MAX / (CHAR_BIT * sizeof(long)) + 1] = {};
+	if(isKeyboard && ::ioctl(fd, EVIOCGKEY(sizeof(keyState)), keyState) >= 0) {
+		for(int i = 0; i < 8; ++i) {
+			if(testBit(keyState, modifierCodes[i]))
+				device.modifierKeys |= 1u << i;
+		}
+	}
+
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.fd = fd;
+	if(::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+		::close(fd);
+		return false;
+	}
+
+	devices.insert(fd, device);
+	return true;
+}
+
+void QHotkeyPrivateEvdev::removeDevice(int fd)
+{
+	::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+	::close(fd);
+	devices.remove(fd);
+}
+
+bool QHotkeyPrivateEvdev::readDevice(Device &device)
+{
+	input_event events[64];
+
+	forever {
+		ssize_t size = ::read(device.fd, events, sizeof(events));
+		if(size < 0)
+			return errno == EAGAIN || errno == EINTR;
+		//a fifo without writers, or an unplugged device
+		if(size == 0)
+			return false;
+
+		const int count = static_cast<int>(size / sizeof(input_event));
+		for(int i = 0; i < count; ++i) {
+			if(events[i].type == EV_KEY)
+				handleKey(device, events[i].code, events[i].value);
+		}
+
+		if(static_cast<size_t>(size) < sizeof(events))
+			return true;
+	}
+}
+
+void QHotkeyPrivateEvdev::handleKey(Device &device, quint16 code, qint32 value)
+{
+	const int bit = modifierBit(code);
+	if(bit >= 0) {
+		if(value)
+			device.modifierKeys |= 1u << bit;
+		else
+			device.modifierKeys &= ~(1u << bit);
+		return;
+	}
+
+	//2 is auto repeat
+	if(value == 1) {
+		const quint32 modifiers = modifierMask(device.modifierKeys);
+		{
+			QMutexLocker locker(&shortcutsMutex);
+			if(!nativeShortcuts.contains(shortcutId(code, modifiers)))
+				return;
+		}
+
+		QHotkey::NativeShortcut shortcut(code, modifiers);
+		pressedShortcuts.insert(code, shortcut);
+
+		//one hop to the gui thread, the signal is emitted directly there
+		QMetaObject::invokeMethod(this, [this, shortcut]() {
+			activateShortcut(shortcut, Qt::DirectConnection);
+		}, Qt::QueuedConnection);
+	} else if(value == 0) {
+		//released even if the modifiers went up first
+		auto it = pressedShortcuts.find(code);
+		if(it == pressedShortcuts.end())
+			return;
+
+		QHotkey::NativeShortcut shortcut = it.value();
+		pressedShortcuts.erase(it);
+
+		QMetaObject::invokeMethod(this, [this, shortcut]() {
+			releaseShortcut(shortcut, Qt::DirectConnection);
+		}, Qt::QueuedConnection);
+	}
+}
@@ -6,6 +6,7 @@
 #include <QMultiHash>
 #include <QMutex>
 #include <QGlobalStatic>
+#include <QStringList>
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 	#define _NATIVE_EVENT_RESULT qintptr
@@ -29,9 +30,12 @@ public:
 	bool addShortcut(QHotkey *hotkey);
 	bool removeShortcut(QHotkey *hotkey);
 
+	int addShortcuts(const QList<QHotkey *> &hotkeys);
+	int removeShortcuts(const QList<QHotkey *> &hotkeys);
+
 protected:
-	void activateShortcut(QHotkey::NativeShortcut shortcut);
-	void releaseShortcut(QHotkey::NativeShortcut shortcut);
+	void activateShortcut(QHotkey::NativeShortcut shortcut, Qt::ConnectionType type = Qt::QueuedConnection);
+	void releaseShortcut(QHotkey::NativeShortcut shortcut, Qt::ConnectionType type = Qt::QueuedConnection);
 
 	virtual quint32 nativeKeycode(Qt::Key keycode, bool &ok) = 0;//platform implement
 	virtual quint32 nativeModifiers(Qt::KeyboardModifiers modifiers, bool &ok) = 0;//platform implement
@@ -39,6 +43,10 @@ protected:
 	virtual bool registerShortcut(QHotkey::NativeShortcut shortcut) = 0;//platform implement
 	virtual bool unregisterShortcut(QHotkey::NativeShortcut shortcut) = 0;//platform implement
 
+	//batch versions, errors get one entry per shortcut, a null string means success
+	virtual void registerShortcuts(const QList<QHotkey::NativeShortcut> &shortcuts, QStringList &errors);//platform may implement
+	virtual void unregisterShortcuts(const QList<QHotkey::NativeShortcut> &shortcuts, QStringList &errors);//platform may implement
+
 	QString error;
 
 private:
@@ -48,6 +56,8 @@ private:
 	Q_INVOKABLE void addMappingInvoked(Qt::Key keycode, Qt::KeyboardModifiers modifiers, QHotkey::NativeShortcut nativeShortcut);
 	Q_INVOKABLE bool addShortcutInvoked(QHotkey *hotkey);
 	Q_INVOKABLE bool removeShortcutInvoked(QHotkey *hotkey);
+	Q_INVOKABLE int addShortcutsInvoked(const QList<QHotkey *> &hotkeys);
+	Q_INVOKABLE int removeShortcutsInvoked(const QList<QHotkey *> &hotkeys);
 	Q_INVOKABLE QHotkey::NativeShortcut nativeShortcutInvoked(Qt::Key keycode, Qt::KeyboardModifiers modifiers);
 };
 
@@ -10,7 +10,12 @@
 
 #include <QThreadStorage>
 #include <QTimer>
+#include <QVector>
+#include <algorithm>
+#include <iterator>
+#include <utility>
 #include <X11/Xlib.h>
+#include <X11/XKBlib.h>
 #include <xcb/xcb.h>
 
 //compatibility to pre Qt 5.8
@@ -31,6 +36,8 @@ protected:
 	static QString getX11String(Qt::Key keycode);
 	bool registerShortcut(QHotkey::NativeShortcut shortcut) Q_DECL_OVERRIDE;
 	bool unregisterShortcut(QHotkey::NativeShortcut shortcut) Q_DECL_OVERRIDE;
+	void registerShortcuts(const QList<QHotkey::NativeShortcut> &shortcuts, QStringList &errors) Q_DECL_OVERRIDE;
+	void unregisterShortcuts(const QList<QHotkey::NativeShortcut> &shortcuts, QStringList &errors) Q_DECL_OVERRIDE;
 
 private:
 	static const QVector<quint32> specialModifiers;
@@ -38,7 +45,19 @@ private:
 	xcb_key_press_event_t prevHandledEvent;
 	xcb_key_press_event_t prevEvent;
 
+	// with detectable auto repeat the server sends press, press, ..., release
+	// for a held key, so releases need no timer and repeats are dropped here
+	void enableDetectableAutoRepeat(Display *display);
+	bool autoRepeatChecked = false;
+	bool detectableAutoRepeat = false;
+	bool pressedKeys[256] = {};
+	// the modifiers may be let go before the key, so the release goes to
+	// the shortcut that the press matched
+	QHotkey::NativeShortcut pressedShortcuts[256];
+
 	static QString formatX11Error(Display *display, int errorCode);
+	static Display *x11Display();
+	static void attributeErrors(Display *display, const QVector<unsigned long> &firstSerials, QStringList &errors);
 
 	class HotkeyErrorHandler {
 	public:
@@ -47,6 +66,8 @@ private:
 
 		static bool hasError;
 		static QString errorString;
+		//serial and error code of every failed grab or ungrab
+		static QVector<QPair<unsigned long, int>> failures;
 
 	private:
 		XErrorHandler prevHandler;
@@ -54,17 +75,38 @@ private:
 		static int handleError(Display *display, XErrorEvent *error);
 	};
 };
-NATIVE_INSTANCE(QHotkeyPrivateX11)
 
-bool QHotkeyPrivate::isPlatformSupported()
+static bool isX11Platform()
 {
 #if QT_VERSION >= QT_VERSION_CHECK(6, 2, 0)
-	return qGuiApp->nativeInterface<QNativeInterface::QX11Application>();
+	return qGuiApp && qGuiApp->nativeInterface<QNativeInterface::QX11Application>();
 #else
 	return QX11Info::isPlatformX11();
 #endif
 }
 
+#ifdef QHOTKEY_EVDEV
+//the evdev backend picks between both at runtime
+Q_GLOBAL_STATIC(QHotkeyPrivateX11, hotkeyPrivateX11)
+
+QHotkeyPrivate *qhotkeyX11Instance()
+{
+	return hotkeyPrivateX11;
+}
+
+bool qhotkeyX11Supported()
+{
+	return isX11Platform();
+}
+#else
+NATIVE_INSTANCE(QHotkeyPrivateX11)
+
+bool QHotkeyPrivate::isPlatformSupported()
+{
+	return isX11Platform();
+}
+#endif
+
 const QVector<quint32> QHotkeyPrivateX11::specialModifiers = {0, Mod2Mask, LockMask, (Mod2Mask | LockMask)};
 const quint32 QHotkeyPrivateX11::validModsMask = ShiftMask | ControlMask | Mod1Mask | Mod4Mask;
 
@@ -74,19 +116,39 @@ bool QHotkeyPrivateX11::nativeEventFilter(const QByteArray &eventType, void *mes
 	Q_UNUSED(result)
 
 	auto *genericEvent = static_cast<xcb_generic_event_t *>(message);
+	if (this->detectableAutoRepeat) {
+		if (genericEvent->response_type == XCB_KEY_PRESS) {
+			auto *keyEvent = static_cast<xcb_key_press_event_t *>(message);
+			if (!this->pressedKeys[keyEvent->detail]) {
+				this->pressedKeys[keyEvent->detail] = true;
+				this->pressedShortcuts[keyEvent->detail] = {keyEvent->detail, keyEvent->state & QHotkeyPrivateX11::validModsMask};
+				this->activateShortcut(this->pressedShortcuts[keyEvent->detail]);
+			}
+		} else if (genericEvent->response_type == XCB_KEY_RELEASE) {
+			auto *keyEvent = static_cast<xcb_key_release_event_t *>(message);
+			if (this->pressedKeys[keyEvent->detail]) {
+				this->pressedKeys[keyEvent->detail] = false;
+				this->releaseShortcut(this->pressedShortcuts[keyEvent->detail]);
+			}
+		}
+		return false;
+	}
+
+	// fallback for servers without XKB, waits to see if a release is followed by a repeated press
 	if (genericEvent->response_type == XCB_KEY_PRESS) {
 		xcb_key_press_event_t keyEvent = *static_cast<xcb_key_press_event_t *>(message);
 		this->prevEvent = keyEvent;
 		if (this->prevHandledEvent.response_type == XCB_KEY_RELEASE) {
 			if(this->prevHandledEvent.time == keyEvent.time) return false;
 		}
-		this->activateShortcut({keyEvent.detail, keyEvent.state & QHotkeyPrivateX11::validModsMask});
+		this->pressedShortcuts[keyEvent.detail] = {keyEvent.detail, keyEvent.state & QHotkeyPrivateX11::validModsMask};
+		this->activateShortcut(this->pressedShortcuts[keyEvent.detail]);
 	} else if (genericEvent->response_type == XCB_KEY_RELEASE) {
 		xcb_key_release_event_t keyEvent = *static_cast<xcb_key_release_event_t *>(message);
 		this->prevEvent = keyEvent;
 		QTimer::singleShot(50, [this, keyEvent] {
 			if(this->prevEvent.time == keyEvent.time && this->prevEvent.response_type == keyEvent.response_type && this->prevEvent.detail == keyEvent.detail){
-				this->releaseShortcut({keyEvent.detail, keyEvent.state & QHotkeyPrivateX11::validModsMask});
+				this->releaseShortcut(this->pressedShortcuts[keyEvent.detail]);
 			}
 		});
 		this->prevHandledEvent = keyEvent;
@@ -164,62 +226,145 @@ quint32 QHotkeyPrivateX11::nativeModifiers(Qt::KeyboardModifiers modifiers, bool
 
 bool QHotkeyPrivateX11::registerShortcut(QHotkey::NativeShortcut shortcut)
 {
-#if QT_VERSION >= QT_VERSION_CHECK(6, 2, 0)
-	const QNativeInterface::QX11Application *x11Interface = qGuiApp->nativeInterface<QNativeInterface::QX11Application>();
-	Display *display = x11Interface->display();
-#else
-	const bool x11Interface = QX11Info::isPlatformX11();
-	Display *display = QX11Info::display();
-#endif
+	QStringList errors;
+	registerShortcuts({shortcut}, errors);
 
-	if(!display || !x11Interface)
+	if(!errors.value(0).isNull()) {
+		error = errors.value(0);
 		return false;
-
-	HotkeyErrorHandler errorHandler;
-	for(quint32 specialMod : QHotkeyPrivateX11::specialModifiers) {
-		XGrabKey(display,
-				 shortcut.key,
-				 shortcut.modifier | specialMod,
-				 DefaultRootWindow(display),
-				 True,
-				 GrabModeAsync,
-				 GrabModeAsync);
 	}
-	XSync(display, False);
+	return true;
+}
+
+bool QHotkeyPrivateX11::unregisterShortcut(QHotkey::NativeShortcut shortcut)
+{
+	QStringList errors;
+	unregisterShortcuts({shortcut}, errors);
 
-	if(errorHandler.hasError) {
-		error = errorHandler.errorString;
-		this->unregisterShortcut(shortcut);
+	if(!errors.value(0).isNull()) {
+		error = errors.value(0);
 		return false;
 	}
 	return true;
 }
 
-bool QHotkeyPrivateX11::unregisterShortcut(QHotkey::NativeShortcut shortcut)
+void QHotkeyPrivateX11::registerShortcuts(const QList<QHotkey::NativeShortcut> &shortcuts, QStringList &errors)
 {
-#if QT_VERSION >= QT_VERSION_CHECK(6, 2, 0)
-	Display *display = qGuiApp->nativeInterface<QNativeInterface::QX11Application>()->display();
-#else
-	Display *display = QX11Info::display();
-#endif
+	Display *display = x11Display();
+	if(!display) {
+		errors = QStringList();
+		for(int i = 0; i < shortcuts.size(); ++i)
+			errors.append(QStringLiteral("X11 display is not available"));
+		return;
+	}
 
-	if(!display)
-		return false;
+	enableDetectableAutoRepeat(display);
+
+	QVector<unsigned long> firstSerials;
+	firstSerials.reserve(shortcuts.size());
+
+	{
+		HotkeyErrorHandler errorHandler;
+		for(QHotkey::NativeShortcut shortcut : shortcuts) {
+			firstSerials.append(NextRequest(display));
+			for(quint32 specialMod : QHotkeyPrivateX11::specialModifiers) {
+				XGrabKey(display,
+						 shortcut.key,
+						 shortcut.modifier | specialMod,
+						 DefaultRootWindow(display),
+						 True,
+						 GrabModeAsync,
+						 GrabModeAsync);
+			}
+		}
+		//one round trip for the whole batch
+		XSync(display, False);
+
+		attributeErrors(display, firstSerials, errors);
+	}
+
+	//drop the grabs that did succeed for a failed shortcut
+	QList<QHotkey::NativeShortcut> failed;
+	for(int i = 0; i < shortcuts.size(); ++i) {
+		if(!errors[i].isNull())
+			failed.append(shortcuts[i]);
+	}
+
+	if(!failed.isEmpty()) {
+		QStringList ungrabErrors;
+		unregisterShortcuts(failed, ungrabErrors);
+	}
+}
+
+void QHotkeyPrivateX11::unregisterShortcuts(const QList<QHotkey::NativeShortcut> &shortcuts, QStringList &errors)
+{
+	Display *display = x11Display();
+	if(!display) {
+		errors = QStringList();
+		for(int i = 0; i < shortcuts.size(); ++i)
+			errors.append(QStringLiteral("X11 display is not available"));
+		return;
+	}
+
+	QVector<unsigned long> firstSerials;
+	firstSerials.reserve(shortcuts.size());
 
 	HotkeyErrorHandler errorHandler;
-	for(quint32 specialMod : QHotkeyPrivateX11::specialModifiers) {
-		XUngrabKey(display,
-				   shortcut.key,
-				   shortcut.modifier | specialMod,
-				   XDefaultRootWindow(display));
+	for(QHotkey::NativeShortcut shortcut : shortcuts) {
+		// the release of a key held while ungrabbing never arrives
+		this->pressedKeys[shortcut.key & 0xFF] = false;
+
+		firstSerials.append(NextRequest(display));
+		for(quint32 specialMod : QHotkeyPrivateX11::specialModifiers) {
+			XUngrabKey(display,
+					   shortcut.key,
+					   shortcut.modifier | specialMod,
+					   XDefaultRootWindow(display));
+		}
 	}
 	XSync(display, False);
 
-	if(HotkeyErrorHandler::hasError) {
-		error = HotkeyErrorHandler::errorString;
-		return false;
+	attributeErrors(display, firstSerials, errors);
+}
+
+Display *QHotkeyPrivateX11::x11Display()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 2, 0)
+	const QNativeInterface::QX11Application *x11Interface = qGuiApp->nativeInterface<QNativeInterface::QX11Application>();
+	return x11Interface ? x11Interface->display() : nullptr;
+#else
+	return QX11Info::isPlatformX11() ? QX11Info::display() : nullptr;
+#endif
+}
+
+void QHotkeyPrivateX11::attributeErrors(Display *display, const QVector<unsigned long> &firstSerials, QStringList &errors)
+{
+	errors = QStringList();
+	for(int i = 0; i < firstSerials.size(); ++i)
+		errors.append(QString());
+
+	//a failed request belongs to the last shortcut whose first request is not after it
+	for(const auto &failure : std::as_const(HotkeyErrorHandler::failures)) {
+		auto it = std::upper_bound(firstSerials.cbegin(), firstSerials.cend(), failure.first);
+		if(it == firstSerials.cbegin())
+			continue;
+
+		int index = static_cast<int>(std::distance(firstSerials.cbegin(), it)) - 1;
+		if(errors[index].isNull())
+			errors[index] = QHotkeyPrivateX11::formatX11Error(display, failure.second);
 	}
-	return true;
+}
+
+void QHotkeyPrivateX11::enableDetectableAutoRepeat(Display *display)
+{
+	if(this->autoRepeatChecked)
+		return;
+
+	this->autoRepeatChecked = true;
+
+	Bool supported = False;
+	XkbSetDetectableAutoRepeat(display, True, &supported);
+	this->detectableAutoRepeat = supported;
 }
 
 QString QHotkeyPrivateX11::formatX11Error(Display *display, int errorCode)
@@ -235,6 +380,7 @@ QString QHotkeyPrivateX11::formatX11Error(Display *display, int errorCode)
 
 bool QHotkeyPrivateX11::HotkeyErrorHandler::hasError = false;
 QString QHotkeyPrivateX11::HotkeyErrorHandler::errorString;
+QVector<QPair<unsigned long, int>> QHotkeyPrivateX11::HotkeyErrorHandler::failures;
 
 QHotkeyPrivateX11::HotkeyErrorHandler::HotkeyErrorHandler()
 {
@@ -246,6 +392,7 @@ QHotkeyPrivateX11::HotkeyErrorHandler::~HotkeyErrorHandler()
 	XSetErrorHandler(prevHandler);
 	hasError = false;
 	errorString.clear();
+	failures.clear();
 }
 
 int QHotkeyPrivateX11::HotkeyErrorHandler::handleError(Display *display, XErrorEvent *error)
@@ -258,6 +405,7 @@ int QHotkeyPrivateX11::HotkeyErrorHandler::handleError(Display *display, XErrorE
 			error->request_code == 34) {// ungrab key
 			hasError = true;
 			errorString = QHotkeyPrivateX11::formatX11Error(display, error->error_code);
+			failures.append({error->serial, error->error_code});
 			return 1;
 		}
 		Q_FALLTHROUGH();
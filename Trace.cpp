@@ -0,0 +1,157 @@
+#include "Trace.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+constexpr uint32_t g_traceRingSize = 8192;
+
+struct TraceRing
+{
+    std::atomic<uint64_t> head = 0;
+    uint32_t thread = 0;
+    QString threadName;
+    TraceEvent events[g_traceRingSize];
+};
+
+std::atomic<bool> Trace::s_enabled = false;
+
+static QMutex g_traceMutex;
+static std::vector<std::unique_ptr<TraceRing>> g_traceRings;
+static int64_t g_traceOrigin = 0;
+
+static thread_local TraceRing* t_traceRing = nullptr;
+
+static TraceRing* threadTraceRing()
+{
+    if (t_traceRing != nullptr)
+        return t_traceRing;
+
+    QMutexLocker locker(&g_traceMutex);
+
+    g_traceRings.push_back(std::make_unique<TraceRing>());
+    t_traceRing = g_traceRings.back().get();
+    t_traceRing->thread = static_cast<uint32_t>(g_traceRings.size());
+
+    QThread* thread = QThread::currentThread();
+    if (QCoreApplication::instance() != nullptr && thread == QCoreApplication::instance()->thread())
+        t_traceRing->threadName = "main";
+    else
+        t_traceRing->threadName = thread->objectName();
+
+    return t_traceRing;
+}
+
+void Trace::setEnabled(bool enabled)
+{
+    if (enabled == isEnabled())
+        return;
+
+    if (enabled)
+    {
+        QMutexLocker locker(&g_traceMutex);
+
+        // A new session starts with empty rings
+        for (const auto& ring : g_traceRings)
+            ring->head.store(0, std::memory_order_relaxed);
+
+        g_traceOrigin = now();
+    }
+
+    s_enabled.store(enabled, std::memory_order_relaxed);
+
+    qDebug() << "Tracing" << (enabled ? "started" : "stopped");
+}
+
+int64_t Trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::record(const char* name, int64_t start, int64_t end, const char* arg)
+{
+    TraceRing* ring = threadTraceRing();
+
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+
+    TraceEvent& event = ring->events[head % g_traceRingSize];
+    event.name = name;
+    event.start = start;
+    event.duration = end - start;
+    event.thread = ring->thread;
+    std::memcpy(event.arg, arg, sizeof(event.arg));
+
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+bool Trace::dump(const QString& filePath)
+{
+    QJsonArray events;
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    {
+        QMutexLocker locker(&g_traceMutex);
+
+        for (const auto& ring : g_traceRings)
+        {
+            QJsonObject nameObject;
+            nameObject["name"] = "thread_name";
+            nameObject["ph"] = "M";
+            nameObject["pid"] = pid;
+            nameObject["tid"] = static_cast<qint64>(ring->thread);
+            nameObject["args"] = QJsonObject{ { "name", ring->threadName.isEmpty() ? QString("thread %1").arg(ring->thread) : ring->threadName } };
+            events.append(nameObject);
+
+            // Spans of other threads may still land while this runs, at worst
+            // the oldest ones are torn, which is fine for a diagnostic dump
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t first = head > g_traceRingSize ? head - g_traceRingSize : 0;
+
+            for (uint64_t i = first; i < head; ++i)
+            {
+                const TraceEvent& event = ring->events[i % g_traceRingSize];
+
+                QJsonObject eventObject;
+                eventObject["name"] = event.name;
+                eventObject["cat"] = "redmiosd";
+                eventObject["ph"] = "X";
+                eventObject["ts"] = (event.start - g_traceOrigin) / 1000.0;
+                eventObject["dur"] = event.duration / 1000.0;
+                eventObject["pid"] = pid;
+                eventObject["tid"] = static_cast<qint64>(event.thread);
+
+                if (event.arg[0] != '\0')
+                    eventObject["args"] = QJsonObject{ { "arg", QString::fromLatin1(event.arg) } };
+
+                events.append(eventObject);
+            }
+        }
+    }
+
+    QJsonObject rootObject;
+    rootObject["traceEvents"] = events;
+    rootObject["displayTimeUnit"] = "ms";
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qDebug() << "Failed to write trace:" << file.errorString();
+        return false;
+    }
+
+    file.write(QJsonDocument(rootObject).toJson(QJsonDocument::Compact));
+
+    qDebug() << "Trace written:" << filePath;
+    return true;
+}
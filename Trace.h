@@ -0,0 +1,102 @@
+#pragma once
+
+#include <QString>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+// One finished span, a Chrome trace "complete" event
+struct TraceEvent
+{
+    const char* name;
+    int64_t start;
+    int64_t duration;
+    uint32_t thread;
+    char arg[36];
+};
+
+static_assert(sizeof(TraceEvent) == 64, "TraceEvent should fill one cache line");
+
+// Opt-in span tracing. Every thread records into a preallocated ring of its
+// own, the newest spans win when it wraps. dump() writes them as Chrome trace
+// event JSON, which chrome://tracing and ui.perfetto.dev open.
+class Trace
+{
+public:
+    static bool isEnabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    static void setEnabled(bool enabled);
+
+    static int64_t now();
+    static void record(const char* name, int64_t start, int64_t end, const char* arg);
+
+    static bool dump(const QString& filePath);
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+// Records the time between construction and destruction. Disabled it costs a
+// relaxed load and a branch, the arg is not even copied.
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* name)
+    {
+        if (!Trace::isEnabled()) return;
+
+        m_name = name;
+        m_arg[0] = '\0';
+        m_start = Trace::now();
+    }
+
+    TraceScope(const char* name, const char* arg)
+    {
+        if (!Trace::isEnabled()) return;
+
+        m_name = name;
+        std::strncpy(m_arg, arg, sizeof(m_arg) - 1);
+        m_arg[sizeof(m_arg) - 1] = '\0';
+        m_start = Trace::now();
+    }
+
+    TraceScope(const char* name, const QString& arg)
+    {
+        if (!Trace::isEnabled()) return;
+
+        m_name = name;
+
+        qsizetype length = std::min<qsizetype>(arg.size(), sizeof(m_arg) - 1);
+        for (qsizetype i = 0; i < length; ++i)
+            m_arg[i] = arg[i].toLatin1();
+
+        m_arg[length] = '\0';
+        m_start = Trace::now();
+    }
+
+    ~TraceScope()
+    {
+        if (m_name != nullptr)
+            Trace::record(m_name, m_start, Trace::now(), m_arg);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_name = nullptr;
+    int64_t m_start = 0;
+    char m_arg[sizeof(TraceEvent::arg)];
+};
+
+#define REDMIOSD_TRACE_JOIN(a, b) a##b
+#define REDMIOSD_TRACE_SCOPE(line) REDMIOSD_TRACE_JOIN(traceScope, line)
+
+// Span until the end of the enclosing block, REDMIOSD_TRACE("name") or
+// REDMIOSD_TRACE("name", arg)
+#define REDMIOSD_TRACE(...) TraceScope REDMIOSD_TRACE_SCOPE(__LINE__)(__VA_ARGS__)
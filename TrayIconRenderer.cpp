@@ -0,0 +1,82 @@
+#include "TrayIconRenderer.h"
+
+#include <QFont>
+#include <QPainter>
+#include <QPixmap>
+
+#include <algorithm>
+#include <cstdio>
+
+constexpr int32_t g_iconSize = 32;
+constexpr int32_t g_glyphWidth = 10;
+constexpr int32_t g_glyphHeight = 16;
+
+TrayIconRenderer::TrayIconRenderer()
+    : m_background(g_iconSize, g_iconSize, QImage::Format_ARGB32_Premultiplied)
+    , m_image(g_iconSize, g_iconSize, QImage::Format_ARGB32_Premultiplied)
+{
+    m_background.fill(Qt::transparent);
+
+    QFont font;
+    font.setBold(true);
+    font.setPixelSize(g_glyphHeight);
+
+    for (int32_t i = 0; i < 10; ++i)
+    {
+        QImage& glyph = m_glyphs[i];
+        glyph = QImage(g_glyphWidth, g_glyphHeight, QImage::Format_ARGB32_Premultiplied);
+        glyph.fill(Qt::transparent);
+
+        QPainter painter(&glyph);
+        painter.setRenderHint(QPainter::TextAntialiasing);
+        painter.setFont(font);
+        painter.setPen(Qt::white);
+        painter.drawText(glyph.rect(), Qt::AlignCenter, QString::number(i));
+    }
+}
+
+TrayIconRenderer::~TrayIconRenderer()
+{
+}
+
+void TrayIconRenderer::setBackground(const QIcon& icon)
+{
+    m_background.fill(Qt::transparent);
+
+    QPainter painter(&m_background);
+    icon.paint(&painter, m_background.rect());
+    painter.end();
+
+    // The next value is drawn even if it did not change
+    m_lastValue = -1;
+}
+
+bool TrayIconRenderer::render(int32_t value, QIcon& icon)
+{
+    value = std::clamp(value, 0, 999);
+    if (value == m_lastValue)
+        return false;
+
+    m_lastValue = value;
+
+    char digits[4];
+    int32_t count = std::snprintf(digits, sizeof(digits), "%d", value);
+
+    int32_t x = (g_iconSize - count * g_glyphWidth) / 2;
+    int32_t y = g_iconSize - g_glyphHeight;
+
+    QPainter painter(&m_image);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(0, 0, m_background);
+
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    painter.fillRect(x - 1, y, count * g_glyphWidth + 2, g_glyphHeight, QColor(0, 0, 0, 160));
+
+    for (int32_t i = 0; i < count; ++i)
+        painter.drawImage(x + i * g_glyphWidth, y, m_glyphs[digits[i] - '0']);
+
+    painter.end();
+
+    icon = QIcon(QPixmap::fromImage(m_image));
+    return true;
+}
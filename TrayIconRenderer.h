@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QIcon>
+#include <QImage>
+
+// Draws a number over the preset icon for the tray. The digits are rasterized
+// once, a new value only blits them into a reused image, and a value equal to
+// the one shown already is skipped.
+class TrayIconRenderer
+{
+public:
+    TrayIconRenderer();
+    ~TrayIconRenderer();
+
+    void setBackground(const QIcon& icon);
+
+    bool render(int32_t value, QIcon& icon);
+
+private:
+    QImage m_glyphs[10];
+    QImage m_background;
+    QImage m_image;
+
+    int32_t m_lastValue = -1;
+};